@@ -0,0 +1,76 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_ADDRESSTABLES_HPP
+#define GAMEBOYEMULATOR_ADDRESSTABLES_HPP
+
+#include <stdint.h>
+#include <array>
+
+/**
+ * A set of addresses stored as one bit per address (8KB for the whole map), so the MMU can check every access against
+ * it with a single bit test rather than a tree lookup.
+ */
+class AddressSet {
+public:
+    AddressSet() : bits{} {}
+
+    bool Contains(uint16_t address) const {return (bits[address >> 6] >> (address & 0x3F)) & 1;}
+    void Insert(uint16_t address) {bits[address >> 6] |= uint64_t(1) << (address & 0x3F);}
+    void Erase(uint16_t address) {bits[address >> 6] &= ~(uint64_t(1) << (address & 0x3F));}
+    void Clear() {bits.fill(0);}
+
+private:
+    std::array<uint64_t, 0x10000 / 64> bits;
+};
+
+/**
+ * Values to bitwise OR into reads of WRAM and its echo (0xC000-0xEFFF), one per address. A bit for each 256 byte page
+ * says whether any address in it has a mask, so reads of pages without one only cost that bit test.
+ */
+class WramOrMask {
+public:
+    WramOrMask() : pages(0), masks{} {}
+
+    bool Contains(uint16_t address) const {return (pages >> ((address - kStart) >> 8)) & 1;}
+    uint8_t Mask(uint16_t address) const {return masks[address - kStart];}
+
+    /**
+     * Sets the mask for a WRAM address, or clears it with 0.
+     */
+    void Set(uint16_t address, uint8_t mask) {
+        masks[address - kStart] = mask;
+        if (mask != 0) {
+            pages |= uint64_t(1) << ((address - kStart) >> 8);
+        }
+    }
+
+    void Clear() {
+        pages = 0;
+        masks.fill(0);
+    }
+
+private:
+    static uint16_t const kStart = 0xC000;
+
+    uint64_t pages; // 48 pages, only ever set, as an unmasked address in a marked page reads the same with a 0 mask
+    std::array<uint8_t, 0x3000> masks;
+};
+
+/**
+ * Redirects reads of an address range to a buffer while active. Writes to the range still reach memory, and while
+ * captureWrites is set are also copied into the buffer, except at offsets marked in writeFilter (if there is one).
+ */
+struct MemoryOverlay {
+    uint16_t start;
+    uint16_t length;
+    uint8_t* data;
+    uint8_t const* writeFilter; // length bytes, non-zero where writes aren't captured, or nullptr
+    bool active;
+    bool captureWrites;
+
+    bool Covers(uint16_t address) const {return active and address >= start and address - start < length;}
+};
+
+#endif //GAMEBOYEMULATOR_ADDRESSTABLES_HPP
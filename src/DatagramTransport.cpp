@@ -0,0 +1,327 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "DatagramTransport.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+std::size_t const DatagramTransport::kBatchSize;
+std::array<std::size_t, 5> const DatagramSizeHistogram::kLimits = {{256, 512, 1024, 1200, 1472}};
+
+void DatagramSizeHistogram::Add(std::size_t size, uint64_t datagrams) {
+    if (datagrams == 0) return;
+    auto bucket = std::lower_bound(kLimits.begin(), kLimits.end(), size) - kLimits.begin();
+    counts[bucket] += datagrams;
+    largest = std::max(largest, size);
+}
+
+uint64_t DatagramSizeHistogram::Total() const {
+    uint64_t total = 0;
+    for (auto count : counts) total += count;
+    return total;
+}
+
+/**
+ * Prints the share of datagrams in each bucket on one line.
+ */
+void DatagramSizeHistogram::Write(std::ostream& output) const {
+    auto total = std::max<uint64_t>(Total(), 1);
+    output << "Datagram sizes:";
+    for (std::size_t bucket = 0; bucket < counts.size(); ++bucket) {
+        output << (bucket == 0 ? " " : ", ");
+        if (bucket < kLimits.size()) {
+            output << "<=" << kLimits[bucket];
+        } else {
+            output << ">" << kLimits.back();
+        }
+        output << ": " << counts[bucket] * 100 / total << "%";
+    }
+    output << "\tLargest: " << largest << " bytes" << std::endl;
+}
+
+namespace {
+    // Asked for in Bind, so a burst arriving between reads (or queued behind a send to every client) isn't dropped. The
+    // OS may give less (Linux caps it at net.core.rmem_max and wmem_max), which only means more is dropped in a burst.
+    int const kSocketBufferSize = 1 << 20;
+
+    template <typename Handle>
+    void EnlargeBuffers(Handle handle) {
+        int size = kSocketBufferSize;
+        setsockopt(handle, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char const*>(&size), sizeof(size));
+        setsockopt(handle, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<char const*>(&size), sizeof(size));
+    }
+}
+
+#ifdef __linux__
+namespace {
+    std::size_t const kMaxDatagramSize = 65507; // As sf::UdpSocket::MaxDatagramSize
+    
+    // Every message is built to at most kMaxMessageSize (1200) bytes (see Network.hpp), so anything longer than a slot
+    // isn't one of ours and is dropped rather than read in part
+    std::size_t const kSlotSize = 2048;
+
+    sockaddr_in SocketAddress(sf::IpAddress const& address, unsigned short port) {
+        sockaddr_in socketAddress{};
+        socketAddress.sin_family = AF_INET;
+        socketAddress.sin_addr.s_addr = htonl(address.toInteger());
+        socketAddress.sin_port = htons(port);
+        return socketAddress;
+    }
+
+    /**
+     * Returns the status sf::UdpSocket gives for the errno of a failed call.
+     */
+    sf::Socket::Status ErrorStatus() {
+        switch (errno) {
+            case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+            case EWOULDBLOCK:
+#endif
+            case EINPROGRESS:
+                return sf::Socket::NotReady;
+            case ECONNREFUSED: case ECONNRESET: case ECONNABORTED: case ENETRESET: case ETIMEDOUT: case EPIPE:
+                return sf::Socket::Disconnected;
+            default:
+                return sf::Socket::Error;
+        }
+    }
+}
+
+DatagramTransport::DatagramTransport()
+    : batched(true)
+    , handle(-1)
+    , blocking(true) {
+}
+
+DatagramTransport::~DatagramTransport() {
+    if (handle >= 0) {
+        close(handle);
+    }
+}
+
+/**
+ * Creates the socket if it hasn't been yet, returning false if it couldn't be.
+ */
+bool DatagramTransport::Create() {
+    if (handle >= 0) return true;
+    handle = socket(AF_INET, SOCK_DGRAM, 0);
+    if (handle < 0) return false;
+    SetBlocking(blocking);
+    EnlargeBuffers(handle);
+    return true;
+}
+
+bool DatagramTransport::Bind(unsigned short port) {
+    if (!Create()) return false;
+    auto address = SocketAddress(sf::IpAddress::Any, port);
+    return bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+unsigned short DatagramTransport::LocalPort() const {
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (handle < 0 or getsockname(handle, reinterpret_cast<sockaddr*>(&address), &length) != 0) return 0;
+    return ntohs(address.sin_port);
+}
+
+void DatagramTransport::SetBlocking(bool blocking) {
+    this->blocking = blocking;
+    if (handle < 0) return;
+    int flags = fcntl(handle, F_GETFL);
+    fcntl(handle, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+}
+
+sf::Socket::Status DatagramTransport::Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) {
+    if (!Create() or packet.getDataSize() > kMaxDatagramSize) return sf::Socket::Error;
+    auto socketAddress = SocketAddress(address, port);
+    if (sendto(handle, packet.getData(), packet.getDataSize(), 0, reinterpret_cast<sockaddr*>(&socketAddress),
+               sizeof(socketAddress)) < 0) {
+        return ErrorStatus();
+    }
+    return sf::Socket::Done;
+}
+
+sf::Socket::Status DatagramTransport::Receive(sf::Packet& packet, sf::IpAddress& sender, unsigned short& port) {
+    packet.clear();
+    if (!Create()) return sf::Socket::Error;
+    buffer.resize(std::max(buffer.size(), kSlotSize));
+
+    sockaddr_in socketAddress{};
+    ssize_t received;
+    do {
+        // With MSG_TRUNC the whole datagram's length is returned, even when only a slot of it was read
+        socklen_t length = sizeof(socketAddress);
+        received = recvfrom(handle, buffer.data(), kSlotSize, MSG_TRUNC, reinterpret_cast<sockaddr*>(&socketAddress), &length);
+        if (received < 0) return ErrorStatus();
+    } while (static_cast<std::size_t>(received) > kSlotSize);
+
+    packet.append(buffer.data(), received);
+    sender = sf::IpAddress(ntohl(socketAddress.sin_addr.s_addr));
+    port = ntohs(socketAddress.sin_port);
+    return sf::Socket::Done;
+}
+
+/**
+ * Receives every datagram waiting without blocking, into datagrams from the front (growing it if there are more than
+ * it holds, but never shrinking it, so its packets' buffers are reused). Returns how many were received.
+ */
+std::size_t DatagramTransport::ReceiveBatch(std::vector<ReceivedDatagram>& datagrams) {
+    if (!batched) return ReceiveEach(datagrams);
+
+    std::size_t count = 0;
+    if (!Create()) return 0;
+    buffer.resize(std::max(buffer.size(), kBatchSize*kSlotSize));
+    mmsghdr messages[kBatchSize];
+    iovec slots[kBatchSize];
+    sockaddr_in senders[kBatchSize];
+    while (true) {
+        for (std::size_t index = 0; index < kBatchSize; ++index) {
+            slots[index].iov_base = &buffer[index*kSlotSize];
+            slots[index].iov_len = kSlotSize;
+            messages[index].msg_hdr = msghdr{};
+            messages[index].msg_hdr.msg_name = &senders[index];
+            messages[index].msg_hdr.msg_namelen = sizeof(senders[index]);
+            messages[index].msg_hdr.msg_iov = &slots[index];
+            messages[index].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = recvmmsg(handle, messages, kBatchSize, MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (ErrorStatus() == sf::Socket::Disconnected) continue;
+            return count;
+        }
+
+        for (int index = 0; index < received; ++index) {
+            if (messages[index].msg_hdr.msg_flags & MSG_TRUNC) continue; // Too long to be ours
+            if (datagrams.size() <= count) datagrams.emplace_back();
+            auto& datagram = datagrams[count++];
+            datagram.packet.clear();
+            datagram.packet.append(slots[index].iov_base, messages[index].msg_len);
+            datagram.sender = sf::IpAddress(ntohl(senders[index].sin_addr.s_addr));
+            datagram.port = ntohs(senders[index].sin_port);
+        }
+        if (static_cast<std::size_t>(received) < kBatchSize) return count;
+    }
+}
+
+/**
+ * Sends the packet to every destination, returning how many it was sent to. A destination it can't be sent to (an
+ * error, or the send buffer is full) is skipped rather than retried.
+ */
+std::size_t DatagramTransport::SendToAll(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) {
+    if (!batched) return SendEach(packet, destinations);
+
+    std::size_t sent = 0;
+    if (!Create() or packet.getDataSize() > kMaxDatagramSize) return 0;
+    iovec data;
+    data.iov_base = const_cast<void*>(packet.getData());
+    data.iov_len = packet.getDataSize();
+    mmsghdr messages[kBatchSize];
+    sockaddr_in addresses[kBatchSize];
+    std::size_t next = 0;
+    while (next < destinations.size()) {
+        std::size_t batch = std::min(kBatchSize, destinations.size() - next);
+        for (std::size_t index = 0; index < batch; ++index) {
+            addresses[index] = SocketAddress(destinations[next + index].address, destinations[next + index].port);
+            messages[index].msg_hdr = msghdr{};
+            messages[index].msg_hdr.msg_name = &addresses[index];
+            messages[index].msg_hdr.msg_namelen = sizeof(addresses[index]);
+            messages[index].msg_hdr.msg_iov = &data;
+            messages[index].msg_hdr.msg_iovlen = 1;
+        }
+
+        // Stops at the first datagram it can't send, which is then skipped
+        int result = sendmmsg(handle, messages, batch, 0);
+        if (result > 0) {
+            sent += result;
+            next += result;
+        } else {
+            ++next;
+        }
+    }
+    return sent;
+}
+
+#else
+
+DatagramTransport::DatagramTransport()
+    : batched(false) {
+}
+
+DatagramTransport::~DatagramTransport() {
+}
+
+bool DatagramTransport::Bind(unsigned short port) {
+    if (socket.bind(port) != sf::Socket::Done) return false;
+    EnlargeBuffers(socket.getHandle());
+    return true;
+}
+
+unsigned short DatagramTransport::LocalPort() const {
+    return socket.getLocalPort();
+}
+
+void DatagramTransport::SetBlocking(bool blocking) {
+    socket.setBlocking(blocking);
+}
+
+sf::Socket::Status DatagramTransport::Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) {
+    return socket.send(packet, address, port);
+}
+
+sf::Socket::Status DatagramTransport::Receive(sf::Packet& packet, sf::IpAddress& sender, unsigned short& port) {
+    return socket.receive(packet, sender, port);
+}
+
+std::size_t DatagramTransport::ReceiveBatch(std::vector<ReceivedDatagram>& datagrams) {
+    return ReceiveEach(datagrams);
+}
+
+std::size_t DatagramTransport::SendToAll(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) {
+    return SendEach(packet, destinations);
+}
+
+#endif
+
+/**
+ * ReceiveBatch a datagram at a time. The socket must not be blocking.
+ */
+std::size_t DatagramTransport::ReceiveEach(std::vector<ReceivedDatagram>& datagrams) {
+    std::size_t count = 0;
+    while (true) {
+        if (datagrams.size() <= count) datagrams.emplace_back();
+        auto& datagram = datagrams[count];
+        auto status = Receive(datagram.packet, datagram.sender, datagram.port);
+        if (status == sf::Socket::Done) {
+            ++count;
+        } else if (status != sf::Socket::Disconnected) {
+            // Disconnected only reports an earlier send that was refused, there may be more waiting behind it
+            return count;
+        }
+    }
+}
+
+/**
+ * SendToAll a datagram at a time.
+ */
+std::size_t DatagramTransport::SendEach(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) {
+    std::size_t sent = 0;
+    for (auto const& destination : destinations) {
+        if (Send(packet, destination.address, destination.port) == sf::Socket::Done) ++sent;
+    }
+    return sent;
+}
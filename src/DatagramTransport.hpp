@@ -0,0 +1,88 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_DATAGRAMTRANSPORT_HPP
+#define GAMEBOYEMULATOR_DATAGRAMTRANSPORT_HPP
+
+#include <stdint.h>
+#include <array>
+#include <ostream>
+#include <vector>
+
+#include <SFML/Network.hpp>
+
+#include "Transport.hpp"
+
+/**
+ * Counts datagrams sent by size, to see how many come near or over the path MTU (1472 bytes of UDP payload on Ethernet)
+ * and so are fragmented.
+ */
+struct DatagramSizeHistogram {
+    static std::array<std::size_t, 5> const kLimits; // The largest size in each bucket but the last
+
+    std::array<uint64_t, 6> counts{};
+    std::size_t largest = 0;
+
+    void Add(std::size_t size, uint64_t datagrams = 1);
+    uint64_t Total() const;
+    void Write(std::ostream& output) const;
+};
+
+/**
+ * A UDP socket that, on top of sending and receiving one packet at a time like sf::UdpSocket, can drain every waiting
+ * datagram and send one packet to many endpoints in batches. On Linux the batches take one recvmmsg or sendmmsg call
+ * per kBatchSize datagrams rather than one call each; elsewhere (or with batched cleared) they fall back to a call per
+ * datagram.
+ */
+class DatagramTransport : public Transport {
+public:
+    static std::size_t const kBatchSize = 32;
+
+    DatagramTransport();
+    ~DatagramTransport() override;
+    DatagramTransport(DatagramTransport const&) = delete;
+    DatagramTransport& operator=(DatagramTransport const&) = delete;
+
+    bool Bind(unsigned short port) override;
+    unsigned short LocalPort() const;
+    void SetBlocking(bool blocking) override;
+
+    sf::Socket::Status Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) override;
+    sf::Socket::Status Receive(sf::Packet& packet, sf::IpAddress& sender, unsigned short& port);
+
+    std::size_t ReceiveBatch(std::vector<ReceivedDatagram>& datagrams) override;
+    std::size_t SendToAll(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) override;
+
+    bool batched; // Use recvmmsg and sendmmsg where they're available
+
+#ifdef __linux__
+    int Handle() const {return handle;} // For waiting on with epoll (see EventLoop)
+#else
+    sf::Socket& Selectable() {return socket;} // For waiting on with sf::SocketSelector (see EventLoop)
+#endif
+
+private:
+    std::size_t ReceiveEach(std::vector<ReceivedDatagram>& datagrams);
+    std::size_t SendEach(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations);
+
+#ifdef __linux__
+    int handle;
+    bool blocking;
+    std::vector<char> buffer; // A slot for Receive, or kBatchSize of them for ReceiveBatch
+
+    bool Create();
+#else
+    /**
+     * An sf::UdpSocket with its OS handle public, to set its buffer sizes.
+     */
+    class Socket : public sf::UdpSocket {
+    public:
+        using sf::UdpSocket::getHandle;
+    };
+
+    Socket socket;
+#endif
+};
+
+#endif //GAMEBOYEMULATOR_DATAGRAMTRANSPORT_HPP
@@ -5,15 +5,18 @@
 #include "Display.hpp"
 #include "Processor.hpp"
 #include "MemoryManagementUnit.hpp"
+#include "Profiler.hpp"
 
 #include <iostream>
 
-Display::Display() {
+Display::Display()
+    : headless(false) {
     Reset();
 }
 
 /**
- * Initializes references to other Gameboy components
+ * Initializes references to other Gameboy components. When headless, only the images drawn into the frame are loaded;
+ * textures and fonts need a graphics context and are only used to draw to a window.
  */
 void Display::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_) {
     cpu = cpu_;
@@ -24,9 +27,11 @@ void Display::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_) {
                                                    "../../data/sprites/cycling.png",
                                                    "../../data/sprites/swimming.png"};
     for (const auto& fileName : textureFileNames) {
-        sf::Texture texture;
-        texture.loadFromFile(fileName);
-        spriteTextures.push_back(texture);
+        if (!headless) {
+            sf::Texture texture;
+            texture.loadFromFile(fileName);
+            spriteTextures.push_back(texture);
+        }
         
         sf::Image image;
         image.loadFromFile(fileName);
@@ -38,15 +43,19 @@ void Display::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_) {
                                                        "../../data/misc/smaller_text_window.png",
                                                        "../../data/misc/text_window.png"};
     for (const auto& fileName : textureTextFileNames) {
-        sf::Texture texture;
-        texture.loadFromFile(fileName);
-        windowTextures.push_back(texture);
+        if (!headless) {
+            sf::Texture texture;
+            texture.loadFromFile(fileName);
+            windowTextures.push_back(texture);
+        }
         
         sf::Image image;
         image.loadFromFile(fileName);
         windowImages.push_back(image);
     }
     
+    if (headless) return;
+    
     // Load fonts
     sf::Font font;
     font.loadFromFile("../../data/font/PokemonGB.ttf");
@@ -72,6 +81,7 @@ void Display::Reset() {
  * Returns the current frame for the GameBoy screen.
  */
 void Display::RenderFrame() {
+    PROFILE_SCOPE(ProfileZone::DISPLAY_FRAME);
 	uint8_t lcd_control = mmu->zram[0xFF40 & 0xFF];
 	if (lcd_control & 0x80) {
 		for (int x = 0; x < 160; ++x) {
@@ -97,6 +107,8 @@ void Display::RenderFrame() {
  * Renders the current scanline.
  */
 void Display::RenderScanline(uint8_t line_number) {
+    PROFILE_SCOPE(ProfileZone::SCANLINE);
+    
     // First draw background (if enabled)
     uint8_t lcd_control = mmu->zram[0xFF40&0xFF];
     //if (lcd_control & 0x01) {
@@ -428,6 +440,7 @@ void Display::UpdateSprite(uint8_t sprite_address, uint8_t value) {
  * Goes through each remote player in the game state and displays them on the screen
  */
 void Display::DisplayPlayers(HostGameState hostGameState, int myUniqueId) {
+    PROFILE_SCOPE(ProfileZone::DISPLAY_PLAYERS);
     auto myPositionX = static_cast<int>(mmu->ReadByte(0xd362));
     auto myPositionY = static_cast<int>(mmu->ReadByte(0xd361));
     auto myDirection = static_cast<int>(mmu->ReadByte(0xC109)); // Need to make sure this direction is correct for when the step counter initially updates
@@ -610,7 +623,7 @@ void Display::DisplayPlayers(HostGameState hostGameState, int myUniqueId) {
         }
     }
     
-    mmu->orBitMask[0xC10C] = orCollisionMask;
+    mmu->orBitMask.Set(0xC10C, orCollisionMask);
 }
 
 /**
@@ -705,7 +718,8 @@ void Display::DrawWindowWithText(const std::string& message, int line) {
         textWindowDrawn = true;
     }
     
-    // Then draw the text to a texture of the image
+    // Then draw the text to a texture of the image (nothing ever renders the text without a window)
+    if (headless) return;
     sf::Text text;
     text.setFont(fonts[0]);
     text.setString(message);
@@ -734,7 +748,8 @@ void Display::DrawOptionsWindowWithText(const std::string& message, int line, bo
         DrawImage(kOptionsWindowOffsetX + 7, kOptionsWindowOffsetY + 9 + line * 12, windowImages[0]);
     }
     
-    // Then draw the text to a texture of the image
+    // Then draw the text to a texture of the image (nothing ever renders the text without a window)
+    if (headless) return;
     sf::Text text;
     text.setFont(fonts[0]);
     text.setString(message);
@@ -749,6 +764,40 @@ void Display::DrawOptionsWindowWithText(const std::string& message, int line, bo
     textQueue.push(textToDisplay);
 }
 
+/**
+ * Returns the 64 bit FNV-1a hash of the current frame's pixels, for checking two runs drew the same thing.
+ */
+uint64_t Display::FrameHash() const {
+    auto pixels = frame.getPixelsPtr();
+    std::size_t size = frame.getSize().x * frame.getSize().y * 4;
+    uint64_t hash = 0xcbf29ce484222325;
+    for (std::size_t index = 0; index < size; ++index) {
+        hash ^= pixels[index];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+/**
+ * Queues a line of text drawn straight over the top left of the screen, with no text window behind it.
+ */
+void Display::DrawOverlayText(const std::string& message, int line) {
+    if (headless) return;
+    
+    sf::Text text;
+    text.setFont(fonts[0]);
+    text.setString(message);
+    text.setCharacterSize(8);
+    text.setColor(sf::Color::Red);
+    
+    TextToDisplay textToDisplay;
+    textToDisplay.offsetY = 2;
+    textToDisplay.offsetX = 2;
+    textToDisplay.text = text;
+    textToDisplay.line = line;
+    textQueue.push(textToDisplay);
+}
+
 /**
  * Draws the provided sf::Image with the given offsets.
  */
@@ -767,17 +816,27 @@ void Display::DrawImage(unsigned int xOffset, unsigned int yOffset, const sf::Im
 }
 
 /**
- * Renders any pending text to render window.
+ * Takes the text queued for the frame just finished, to be drawn over it (RenderText) when it is presented.
  */
-void Display::RenderText(sf::RenderWindow& window) {
+std::vector<TextToDisplay> Display::TakeText() {
+    std::vector<TextToDisplay> text;
     while (!textQueue.empty()) {
-        auto& textToDisplay = textQueue.front();
-        textToDisplay.text.setPosition(textToDisplay.offsetX, textToDisplay.offsetY + textToDisplay.line*13);
-        window.draw(textToDisplay.text);
+        text.push_back(textQueue.front());
         textQueue.pop();
     }
     textWindowDrawn = false;
     textOptionsWindowDrawn = false;
+    return text;
+}
+
+/**
+ * Renders a frame's text to render window.
+ */
+void Display::RenderText(sf::RenderWindow& window, std::vector<TextToDisplay>& text) {
+    for (auto& textToDisplay : text) {
+        textToDisplay.text.setPosition(textToDisplay.offsetX, textToDisplay.offsetY + textToDisplay.line*13);
+        window.draw(textToDisplay.text);
+    }
 }
 
 /**
@@ -112,13 +112,17 @@ public:
     void DrawSpriteToImage(sf::Image spriteImage, int frame, int pixelPositionX, int pixelPositionY);
     void DrawWindowWithText(const std::string& message, int line);
     void DrawOptionsWindowWithText(const std::string& message, int line, bool selected);
-    void RenderText(sf::RenderWindow& window);
+    void DrawOverlayText(const std::string& message, int line);
+    std::vector<TextToDisplay> TakeText();
+    static void RenderText(sf::RenderWindow& window, std::vector<TextToDisplay>& text);
     int FacingOtherPlayer();
     
     bool ItemIsSelected(const sf::Image& image);
+    uint64_t FrameHash() const;
     
 	sf::Image frame;
     std::unordered_map<int, SimulatedPlayerState> simulatedPlayerStates;
+    bool headless; // Set before Initialize to skip loading anything that needs a window
 	
 private:
     Processor* cpu;
@@ -0,0 +1,203 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "EventLoop.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // How long to wait when there are no timers, just so a missed wake up can't leave the thread asleep forever
+    std::chrono::milliseconds const kMaxWait(1000);
+}
+
+/**
+ * Adds a transport to wait on. Only before Start.
+ */
+void EventLoop::Watch(DatagramTransport& transport, std::function<void()> onReadable) {
+    watched.push_back({&transport, std::move(onReadable)});
+}
+
+/**
+ * Adds a timer that runs every interval, starting an interval after Start. Only before Start.
+ */
+void EventLoop::Every(std::chrono::nanoseconds interval, std::function<void()> onTimer) {
+    timers.push_back({interval, std::chrono::steady_clock::time_point(), std::move(onTimer)});
+}
+
+/**
+ * Runs the timers that are due, returning when the next one is.
+ */
+std::chrono::steady_clock::time_point EventLoop::RunTimers() {
+    auto now = std::chrono::steady_clock::now();
+    auto next = now + kMaxWait;
+    for (auto& timer : timers) {
+        if (now >= timer.next) {
+            timer.onTimer();
+            // Skips any intervals missed rather than running the timer for each of them
+            timer.next += timer.interval * ((now - timer.next) / timer.interval + 1);
+        }
+        next = std::min(next, timer.next);
+    }
+    return next;
+}
+
+#ifdef __linux__
+
+EventLoop::EventLoop()
+    : running(false)
+    , epollHandle(-1)
+    , wakeHandle(-1) {
+}
+
+EventLoop::~EventLoop() {
+    Stop();
+}
+
+/**
+ * Starts the thread, returning false if it couldn't be (the owner should then poll its transports itself).
+ */
+bool EventLoop::Start() {
+    if (running) return true;
+
+    epollHandle = epoll_create1(EPOLL_CLOEXEC);
+    wakeHandle = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    bool watching = epollHandle >= 0 and wakeHandle >= 0;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = watched.size(); // One past the transports is the wake up
+    watching = watching and epoll_ctl(epollHandle, EPOLL_CTL_ADD, wakeHandle, &event) == 0;
+    for (std::size_t index = 0; index < watched.size() and watching; ++index) {
+        event.data.u64 = index;
+        watching = epoll_ctl(epollHandle, EPOLL_CTL_ADD, watched[index].transport->Handle(), &event) == 0;
+    }
+    if (!watching) {
+        if (epollHandle >= 0) close(epollHandle);
+        if (wakeHandle >= 0) close(wakeHandle);
+        epollHandle = wakeHandle = -1;
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& timer : timers) {
+        timer.next = now + timer.interval;
+    }
+    running = true;
+    thread = std::thread(&EventLoop::Run, this);
+    return true;
+}
+
+/**
+ * Wakes the thread and waits for it to exit. Safe to call when it isn't running.
+ */
+void EventLoop::Stop() {
+    if (!running) return;
+    running = false;
+    uint64_t one = 1;
+    if (write(wakeHandle, &one, sizeof(one)) < 0) {
+        // Full counter, which already wakes it
+    }
+    thread.join();
+    close(epollHandle);
+    close(wakeHandle);
+    epollHandle = wakeHandle = -1;
+}
+
+void EventLoop::Run() {
+    epoll_event events[16];
+    auto nextTimer = RunTimers();
+    while (running) {
+        // Rounded up, so it never wakes just before a timer is due and has to sleep again
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            nextTimer - std::chrono::steady_clock::now() + std::chrono::microseconds(999));
+        int count = epoll_wait(epollHandle, events, 16, std::max<int>(wait.count(), 0));
+
+        for (int index = 0; index < count; ++index) {
+            auto which = events[index].data.u64;
+            if (which < watched.size()) {
+                watched[which].onReadable();
+            }
+        }
+        nextTimer = RunTimers();
+    }
+}
+
+#else
+
+EventLoop::EventLoop()
+    : running(false) {
+}
+
+EventLoop::~EventLoop() {
+    Stop();
+}
+
+/**
+ * Starts the thread, returning false if it couldn't be (the owner should then poll its transports itself).
+ */
+bool EventLoop::Start() {
+    if (running) return true;
+
+    if (wakeSocket.bind(sf::Socket::AnyPort) != sf::Socket::Done) return false;
+    wakeSocket.setBlocking(false);
+    selector.clear();
+    selector.add(wakeSocket);
+    for (auto& watching : watched) {
+        selector.add(watching.transport->Selectable());
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& timer : timers) {
+        timer.next = now + timer.interval;
+    }
+    running = true;
+    thread = std::thread(&EventLoop::Run, this);
+    return true;
+}
+
+/**
+ * Wakes the thread and waits for it to exit. Safe to call when it isn't running.
+ */
+void EventLoop::Stop() {
+    if (!running) return;
+    running = false;
+    char wake = 0;
+    wakeSocket.send(&wake, sizeof(wake), sf::IpAddress::LocalHost, wakeSocket.getLocalPort());
+    thread.join();
+    wakeSocket.unbind();
+}
+
+void EventLoop::Run() {
+    char discarded[16];
+    std::size_t received;
+    sf::IpAddress sender;
+    unsigned short port;
+    auto nextTimer = RunTimers();
+    while (running) {
+        // At least a microsecond, as no time at all would wait forever
+        auto wait = std::chrono::duration_cast<std::chrono::microseconds>(nextTimer - std::chrono::steady_clock::now());
+        if (selector.wait(sf::microseconds(std::max<sf::Int64>(wait.count(), 1)))) {
+            for (auto& watching : watched) {
+                if (selector.isReady(watching.transport->Selectable())) {
+                    watching.onReadable();
+                }
+            }
+            if (selector.isReady(wakeSocket)) {
+                // Drained whoever sent it, as it's bound to every interface and would otherwise keep waking the thread
+                while (wakeSocket.receive(discarded, sizeof(discarded), received, sender, port) == sf::Socket::Done) {
+                }
+            }
+        }
+        nextTimer = RunTimers();
+    }
+}
+
+#endif
@@ -0,0 +1,67 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_EVENTLOOP_HPP
+#define GAMEBOYEMULATOR_EVENTLOOP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "DatagramTransport.hpp"
+
+/**
+ * A thread that sleeps until one of its transports has datagrams waiting or one of its timers is due, and runs the
+ * callback for it. It wakes as soon as a datagram arrives and costs nothing while none do, waiting with epoll on Linux
+ * and sf::SocketSelector elsewhere.
+ *
+ * Transports and timers are added before Start, and their callbacks run on the loop's thread. A readable callback must
+ * drain its transport (which must not be blocking), as it's only called again once more arrives.
+ */
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(EventLoop const&) = delete;
+    EventLoop& operator=(EventLoop const&) = delete;
+
+    void Watch(DatagramTransport& transport, std::function<void()> onReadable);
+    void Every(std::chrono::nanoseconds interval, std::function<void()> onTimer);
+    bool Start();
+    void Stop();
+
+    bool Running() const {return running;}
+
+private:
+    struct Watched {
+        DatagramTransport* transport;
+        std::function<void()> onReadable;
+    };
+
+    struct Timer {
+        std::chrono::nanoseconds interval;
+        std::chrono::steady_clock::time_point next;
+        std::function<void()> onTimer;
+    };
+
+    std::vector<Watched> watched;
+    std::vector<Timer> timers;
+    std::atomic<bool> running;
+    std::thread thread;
+
+#ifdef __linux__
+    int epollHandle;
+    int wakeHandle; // An eventfd written to by Stop, so the thread wakes to see it should exit
+#else
+    sf::SocketSelector selector;
+    sf::UdpSocket wakeSocket; // Sent a datagram by Stop, so the thread wakes to see it should exit
+#endif
+
+    void Run();
+    std::chrono::steady_clock::time_point RunTimers(); // Returns when the next timer is due
+};
+
+#endif //GAMEBOYEMULATOR_EVENTLOOP_HPP
@@ -7,20 +7,36 @@
 #include <iostream>
 #include <fstream>
 
-GameBoy::GameBoy(sf::RenderWindow& window, std::string name, unsigned short port, std::string ipAddress, unsigned short hostPort)
+GameBoy::GameBoy(sf::RenderWindow& window)
+    : GameBoy(&window) {
+}
+
+GameBoy::GameBoy()
+    : GameBoy(nullptr) {
+}
+
+GameBoy::GameBoy(sf::RenderWindow* window)
 	: screen_size(1)
 	, game_speed(1) {
-    cpu.Initialize(&mmu);
-    mmu.Initialize(&cpu, &input, &display, &timer, &network);
+    input.headless = (window == nullptr);
+    display.headless = (window == nullptr);
+    
+    cpu.Initialize(&mmu, &counters);
+    mmu.Initialize(&cpu, &input, &display, &timer, &network, &counters);
     display.Initialize(&cpu, &mmu);
-    timer.Initialize(&cpu, &mmu, &display);
-	input.Initialize(&mmu, &display, &timer, &cpu, this, &network, &window);
-    network.Initialize(&mmu, &display, &timer, &cpu, &input, this, &window);
+    timer.Initialize(&cpu, &mmu, &display, &counters);
+	input.Initialize(&mmu, &display, &timer, &cpu, this, &network, &movie, window);
+    network.Initialize(&mmu, &display, &timer, &cpu, &input, this, window, &counters);
+    movie.Initialize(&cpu, &mmu, &display, &input);
+    idleLoops.Initialize(&cpu, &mmu, &timer, &counters);
 
 	Reset();
-    
-    // Attempt to connect as either host or client
-    // If IP Address provided, connect as client
+}
+
+/**
+ * Attempt to connect as either host or client. If an IP Address is provided, connects as a client.
+ */
+void GameBoy::StartNetwork(std::string name, unsigned short port, std::string ipAddress, unsigned short hostPort) {
     if (ipAddress != "") {  
         network.Connect(sf::IpAddress(ipAddress), hostPort, port, name);
     } else {
@@ -30,18 +46,36 @@ GameBoy::GameBoy(sf::RenderWindow& window, std::string name, unsigned short port
 
 void GameBoy::LoadGame(std::string rom_name, std::string save_file) {
     mmu.LoadRom(rom_name);
+    cpu.ClearBlockCache();
+    idleLoops.Reset();
     if (save_file != "") {
         mmu.LoadSave(save_file);
     }
 }
 
+/**
+ * Starts writing every frame's performance counters to a CSV file, one row per frame.
+ */
+bool GameBoy::WriteCountersCsv(std::string const& file_name) {
+    countersCsv.open(file_name);
+    if (!countersCsv) return false;
+    PerformanceCounters::WriteCsvHeader(countersCsv);
+    return true;
+}
+
 void GameBoy::Reset() {
     cpu.Reset();
     mmu.Reset();
     timer.Reset();
+    idleLoops.Reset();
     frame_counter = 0;
+    counters = PerformanceCounters();
+    frameCounters = PerformanceCounters();
+    totalCounters = PerformanceCounters();
+    countedFrames = 0;
     
     synchronizedMap = false;
+    spritesOutOfSync = -1;
     initiateBattleFlag = false;
     updateCounter = 0;
     updateRate = 12;
@@ -49,13 +83,19 @@ void GameBoy::Reset() {
 
 // Todo: Frame calling v-blank 195-196x per frame??
 std::pair<sf::Image, bool> GameBoy::RenderFrame() {
-    // First check for any updates on the network
+#ifdef POKESYNCH_PROFILER
+    profiler.BeginFrame();
+#endif
+    
+    // First handle whatever arrived from the network since the last frame, and every updateRate frames exchange game states
+    auto networkStart = std::chrono::steady_clock::now();
+    network.ProcessMessages();
     HostGameState hostGameState;
     if (updateCounter++ % updateRate == 0) {
-        NetworkGameState localGameState = CreateGameState();
-        hostGameState = network.Update(localGameState);
+        hostGameState = network.Update(GameStateView(mmu.wram));
         UpdateLocalGameState(hostGameState, network.isHost);
     }
+    counters.networkTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - networkStart).count();
     
     if (initiateBattleFlag) {
         InitiateBattle();
@@ -65,53 +105,25 @@ std::pair<sf::Image, bool> GameBoy::RenderFrame() {
     //DebugPrint();
     
     bool running = (input.PollEvents())?true:false;
-	cpu.frame_clock = cpu.clock + 17556; // Number of cycles/4 for one frame before v-blank
-	bool v_blank = false;
-	do {
-        if (cpu.halt) {
-            cpu.clock += 1;
-        } else {
-            cpu.ExecuteNextInstruction();
-        }
-
-        uint8_t if_memory_value = mmu.ReadByte(0xFF0F);
-        if (mmu.interrupt_enable and cpu.interrupt_master_enable and if_memory_value) {
-			cpu.halt = 0;
-			cpu.interrupt_master_enable = 0;
-			uint8_t interrupt_fired = mmu.interrupt_enable & if_memory_value;
-
-            if (interrupt_fired & 0x01) {if_memory_value &= 0XFE; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST40();}
-			else if (interrupt_fired & 0x02) {if_memory_value &= 0XFD; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST48();}
-			else if (interrupt_fired & 0x04) {if_memory_value &= 0XFB; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST50();}
-			else if (interrupt_fired & 0x08) {if_memory_value &= 0XF7; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST58();}
-			else if (interrupt_fired & 0x10) {if_memory_value &= 0XEF; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST60();}
-			else {cpu.interrupt_master_enable = 1;}
-			
-			mmu.WriteByte(0xFF0F, if_memory_value);
-		}
-		
-		timer.Increment();
-	} while(cpu.clock < cpu.frame_clock and !(network.inBattle and mmu.reachedSelectEnemyMove));
-	
-	if (!v_blank) {
-		display.RenderFrame();
-        if (mmu.ReadByte(0xd057) != 2) {
-            // If not in battle, do usual display of players and dialogue
-            display.DisplayPlayers(hostGameState, network.uniqueId);
-            DrawDialogueWithPlayer();
-        } else if (network.inBattle) {
-            // Display battle dialogue
-            if (mmu.reachedSelectEnemyMove) {
-                // TODO: Add a timeout for this (in case remote player disconnects)
-                //std::cout << "Sending player move from gameboy" << std::endl;
-                DrawWaitingForEnemyMove();
-                network.SendPlayerMove(input.talkingWithPlayer, 
-                                       static_cast<int>(mmu.ReadByte(0xccdc)), // wPlayerSelectedMove
-                                       static_cast<int>(mmu.ReadByte(0xcd6a)), // wActionResultOrTookBattleTurn
-                                       static_cast<int>(mmu.ReadByte(0xcf92))); // wWhichPokemon
-            }
+    RunCycles(kCyclesPerFrame);
+    
+    display.RenderFrame();
+    if (mmu.ReadByte(0xd057) != 2) {
+        // If not in battle, do usual display of players and dialogue
+        display.DisplayPlayers(hostGameState, network.uniqueId);
+        DrawDialogueWithPlayer();
+    } else if (network.inBattle) {
+        // Display battle dialogue
+        if (mmu.reachedSelectEnemyMove) {
+            // TODO: Add a timeout for this (in case remote player disconnects)
+            //std::cout << "Sending player move from gameboy" << std::endl;
+            DrawWaitingForEnemyMove();
+            network.SendPlayerMove(input.talkingWithPlayer, 
+                                   static_cast<int>(mmu.ReadByte(0xccdc)), // wPlayerSelectedMove
+                                   static_cast<int>(mmu.ReadByte(0xcd6a)), // wActionResultOrTookBattleTurn
+                                   static_cast<int>(mmu.ReadByte(0xcf92))); // wWhichPokemon
         }
-	}
+    }
     
     if (network.inBattle and display.ItemIsSelected(display.frame)) {
         input.ignoreA = true;
@@ -119,10 +131,29 @@ std::pair<sf::Image, bool> GameBoy::RenderFrame() {
         input.ignoreA = false;
     }
 	
-    // Update the .SAV file if flagged (once per second)
+#ifdef POKESYNCH_PROFILER
+    if (profiler.showOverlay) {
+        auto lines = profiler.OverlayLines();
+        for (std::size_t line = 0; line < lines.size(); ++line) {
+            display.DrawOverlayText(lines[line], line);
+        }
+    }
+#endif
+    
+    movie.EndFrame();
+    
+    frameCounters = counters;
+    totalCounters += counters;
+    counters = PerformanceCounters();
+    if (countersCsv.is_open()) {
+        frameCounters.WriteCsvRow(countersCsv, countedFrames);
+    }
+    ++countedFrames;
+	
+    // Update the .SAV file if flagged (once per second), leaving it alone while replaying a movie
     if (++frame_counter >= 60) {
         frame_counter = 0;
-        if (mmu.updateSaveFile) {
+        if (mmu.updateSaveFile and !movie.IsReplaying()) {
             SaveGame();
              mmu.updateSaveFile = false;
         }
@@ -131,41 +162,79 @@ std::pair<sf::Image, bool> GameBoy::RenderFrame() {
 	return std::make_pair(display.frame, running);
 }
 
-NetworkGameState GameBoy::CreateGameState() {
-    NetworkGameState localGameState;
-    
-    localGameState.currentMap = mmu.wram[0xD35E & 0x1FFF];
-    localGameState.walkBikeSurfState = mmu.ReadByte(0xd700);
-    
-    localGameState.playerPosition.yPosition = mmu.wram[0xD361 & 0x1FFF];
-    localGameState.playerPosition.xPosition = mmu.wram[0xD362 & 0x1FFF];
-    localGameState.playerPosition.yBlockPosition = mmu.wram[0xD363 & 0x1FFF];
-    localGameState.playerPosition.xBlockPosition = mmu.wram[0xD364 & 0x1FFF];
-    
-    localGameState.sprites.resize(16);
-    for (uint16_t index = 0; index < 16; ++index) {
-        uint16_t offset = (0xC100 + index*0x10) & 0x1FFF;
-        uint16_t offset2 = (0xC200 + index*0x10) & 0x1FFF;
-        
-        auto& sprite = localGameState.sprites[index];
-        sprite.spriteIndex = index;
-        sprite.pictureId = mmu.wram[offset + 0x0];
-        sprite.moveStatus = mmu.wram[offset + 0x1];
-        sprite.direction = mmu.wram[offset + 0x9];
-        sprite.yDisplacement = mmu.wram[offset2 + 0x2];
-        sprite.xDisplacement = mmu.wram[offset2 + 0x3];
-        sprite.yPosition = mmu.wram[offset2 + 0x4];
-        sprite.xPosition = mmu.wram[offset2 + 0x5];
-        sprite.canMove = mmu.wram[offset2 + 0x6];
-        sprite.inGrass = mmu.wram[offset2 + 0x7];
+/**
+ * Runs one instruction (or one halted cycle), takes any interrupt due and catches the timers up. Returns whether an
+ * interrupt was taken.
+ */
+inline bool GameBoy::Step() {
+    if (cpu.halt) {
+        cpu.clock += 1;
+        ++counters.haltedCycles;
+    } else {
+        cpu.ExecuteNextInstruction();
     }
-    
-    unsigned int offset = 0xd163;
-    for (unsigned int index = 0; index < 0x108+8; ++index) {
-        localGameState.partyMonsters[index] = mmu.wram[(offset+index) & 0x1FFF];
+
+    bool interrupted = false;
+    uint8_t if_memory_value = mmu.ReadByte(0xFF0F);
+    if (mmu.interrupt_enable and cpu.interrupt_master_enable and if_memory_value) {
+		cpu.halt = 0;
+		cpu.interrupt_master_enable = 0;
+		uint8_t interrupt_fired = mmu.interrupt_enable & if_memory_value;
+		interrupted = true;
+
+        if (interrupt_fired & 0x01) {if_memory_value &= 0XFE; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST40(); ++counters.interrupts[0];}
+		else if (interrupt_fired & 0x02) {if_memory_value &= 0XFD; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST48(); ++counters.interrupts[1];}
+		else if (interrupt_fired & 0x04) {if_memory_value &= 0XFB; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST50(); ++counters.interrupts[2];}
+		else if (interrupt_fired & 0x08) {if_memory_value &= 0XF7; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST58(); ++counters.interrupts[3];}
+		else if (interrupt_fired & 0x10) {if_memory_value &= 0XEF; mmu.WriteByte(0xFF0F, if_memory_value); cpu.RST60(); ++counters.interrupts[4];}
+		else {cpu.interrupt_master_enable = 1; interrupted = false;}
+		
+		mmu.WriteByte(0xFF0F, if_memory_value);
+	}
+	
+	timer.Increment();
+    if (cpu.jumpedBack) {
+        idleLoops.Update();
     }
+    return interrupted;
+}
+
+/**
+ * Runs the CPU, interrupts, timers and LCD for a number of clocks/4, and nothing else: no networking, input, frame
+ * drawing or .sav writes, so frame loops, headless runners and schedulers can run as much as they need at a time.
+ *
+ * Instructions can't be split, so this runs until the budget is used up and returns the cycles actually run, which can
+ * be a few over (or fewer, if a remote battle is waiting on the other player's move).
+ */
+uint64_t GameBoy::RunCycles(uint64_t cycles) {
+    uint64_t start = cpu.clock;
+    RunUntil(RunEvent::CYCLES, cycles);
+    return cpu.clock - start;
+}
+
+/**
+ * Runs like RunCycles until the event happens or max_cycles have run, and returns which it was.
+ */
+RunEvent GameBoy::RunUntil(RunEvent event, uint64_t max_cycles) {
+    PROFILE_SCOPE(ProfileZone::CPU);
+    idleLoops.BeginRun();
+    cpu.frame_clock = cpu.clock + max_cycles;
     
-    return localGameState;
+    while (cpu.clock < cpu.frame_clock) {
+        uint8_t scanline = timer.scanline;
+        bool v_blank = timer.v_blank_triggered;
+        bool interrupted = Step();
+        
+        if (network.inBattle and mmu.reachedSelectEnemyMove) return RunEvent::REMOTE_MOVE;
+        switch (event) {
+            case RunEvent::SCANLINE:  if (timer.scanline != scanline) return event; break;
+            case RunEvent::VBLANK:    if (timer.v_blank_triggered and !v_blank) return event; break;
+            case RunEvent::INTERRUPT: if (interrupted) return event; break;
+            case RunEvent::HALT:      if (cpu.halt) return event; break;
+            default: break;
+        }
+    }
+    return RunEvent::CYCLES;
 }
 
 /**
@@ -179,10 +248,14 @@ void GameBoy::UpdateLocalGameState(const HostGameState& hostGameState, bool isHo
     // If on the same map, synchronize sprites
     if (!isHost && hostGameState.playerGameStates[0].currentMap == mmu.wram[0xD35E & 0x1FFF]) {
         auto numberOfSprites = static_cast<uint16_t>(mmu.wram[0xd4e1 & 0x1fff]);
+        spritesOutOfSync = 0;
         for (uint16_t index = 1; index < 16; ++index) {
             const auto& sprite = hostGameState.sprites[index];
             uint16_t offset = (0xC100 + index*0x10);
             uint16_t offset2 = (0xC200 + index*0x10);
+            if (mmu.ReadByte(offset2 + 0x5) != sprite.xPosition or mmu.ReadByte(offset2 + 0x4) != sprite.yPosition) {
+                ++spritesOutOfSync;
+            }
             
             if (!synchronizedMap || std::abs(static_cast<int>(mmu.ReadByte(offset2 + 0x5)) - 4 - static_cast<int>(mmu.ReadByte(0xd362))) > 4 ||
                                     std::abs(static_cast<int>(mmu.ReadByte(offset2 + 0x4)) - 4 - static_cast<int>(mmu.ReadByte(0xd361))) > 4 ||
@@ -228,6 +301,7 @@ void GameBoy::UpdateLocalGameState(const HostGameState& hostGameState, bool isHo
         }
     } else {
         synchronizedMap = false;
+        spritesOutOfSync = -1;
     }
 }
 
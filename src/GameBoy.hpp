@@ -13,6 +13,7 @@
 
 #include <Utility>
 #include <array>
+#include <fstream>
 
 #include "Processor.hpp"
 #include "MemoryManagementUnit.hpp"
@@ -20,6 +21,10 @@
 #include "Timer.hpp"
 #include "Input.hpp"
 #include "Network.hpp"
+#include "Movie.hpp"
+#include "IdleLoopDetector.hpp"
+#include "Profiler.hpp"
+#include "PerformanceCounters.hpp"
 
 /**
  * Holds meta data related to the sprites.
@@ -61,6 +66,18 @@ struct Pokemon {
     uint16_t special;
 };
 
+/**
+ * What GameBoy::RunUntil can stop at, and what stopped it.
+ */
+enum class RunEvent {
+    CYCLES,     // The cycle budget ran out
+    SCANLINE,   // LY moved on to another line
+    VBLANK,     // The LCD entered V-Blank
+    INTERRUPT,  // An interrupt was taken
+    HALT,       // The CPU halted
+    REMOTE_MOVE // A remote battle is waiting on the other player's move, so nothing more can run until it arrives
+};
+
 /**
  * Emulates a GameBoy, outputting visuals to an sf::Image (160x144 pixels)
  */
@@ -68,12 +85,19 @@ class GameBoy {
 public:
 	int screen_size; // Multiplier
 	int game_speed; // Multiplier
+	
+	static uint64_t const kCyclesPerFrame = 17556; // Clocks/4 from one V-Blank to the next
 
-    GameBoy(sf::RenderWindow& window, std::string name = "", unsigned short port = 34231, std::string ipAddress = "", unsigned short hostPort = 34232);
+    GameBoy(sf::RenderWindow& window);
+    GameBoy(); // Headless, with no window or keyboard (input comes from Input::KeyDown/KeyUp)
 
+    void StartNetwork(std::string name = "", unsigned short port = 34231, std::string ipAddress = "", unsigned short hostPort = 34232);
     void Reset();
     std::pair<sf::Image, bool> RenderFrame();
+    uint64_t RunCycles(uint64_t cycles);
+    RunEvent RunUntil(RunEvent event, uint64_t max_cycles = kCyclesPerFrame);
     void LoadGame(std::string rom_name, std::string save_file);
+    bool WriteCountersCsv(std::string const& file_name);
     
     void SelectRemotePlayerMove(int move);
 
@@ -82,6 +106,7 @@ public:
     unsigned int frame_counter;
     bool initiateBattleFlag;
     bool synchronizedMap;
+    int spritesOutOfSync; // Of the host's NPCs, how many weren't where the host had them at the last sync (-1 if not syncing)
     unsigned int updateCounter;
     unsigned int updateRate;
 
@@ -91,10 +116,20 @@ public:
     Timer timer;
     Input input;
     Network network;
+    Movie movie;
+    IdleLoopDetector idleLoops;
+    PerformanceCounters counters; // The frame being run
+    PerformanceCounters frameCounters; // The last finished frame
+    PerformanceCounters totalCounters; // Every finished frame since Reset
+    uint64_t countedFrames;
+    std::ofstream countersCsv;
+#ifdef POKESYNCH_PROFILER
+    Profiler profiler;
+#endif
     
     void SaveGame();
+    bool Step();
 
-    NetworkGameState CreateGameState();
     void UpdateLocalGameState(const HostGameState& hostGameState, bool isHost);
     
     bool TileCollisionInFront(const HostGameState& hostGameState);
@@ -104,6 +139,9 @@ public:
     void DebugPrint();
     void DrawDialogueWithPlayer();
     void DrawWaitingForEnemyMove();
+    
+private:
+    explicit GameBoy(sf::RenderWindow* window);
 };
 
 #endif //GAMEBOYEMULATOR_GAMEBOY_HPP
@@ -0,0 +1,226 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "IdleLoopDetector.hpp"
+#include "Processor.hpp"
+#include "MemoryManagementUnit.hpp"
+#include "Timer.hpp"
+#include "PerformanceCounters.hpp"
+#include "Opcodes.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+namespace {
+    /**
+     * Returns whether reading the address gives the same value every time until the timers, LCD or an interrupt change
+     * something. Reading the joypad samples the keyboard (or a replayed movie), and cartridge RAM can be a real time
+     * clock.
+     */
+    bool StableRead(uint16_t address) {
+        return address != 0xFF00 and (address < 0xA000 or address >= 0xC000);
+    }
+}
+
+IdleLoopDetector::IdleLoopDetector()
+    : enabled(true) {
+    Reset();
+}
+
+void IdleLoopDetector::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Timer* timer_, PerformanceCounters* counters_) {
+    cpu = cpu_;
+    mmu = mmu_;
+    timer = timer_;
+    counters = counters_;
+}
+
+void IdleLoopDetector::Reset() {
+    loops.clear();
+    cyclesSkipped = 0;
+    tracking = false;
+}
+
+/**
+ * Forgets the loop being tracked, as anything could have changed between runs (network updates, loaded states).
+ */
+void IdleLoopDetector::BeginRun() {
+    tracking = false;
+}
+
+/**
+ * Called after an instruction jumped back (and the timers caught up with it), at the start of the loop it closed.
+ */
+void IdleLoopDetector::Update() {
+    cpu->jumpedBack = false;
+    if (!enabled) return;
+
+    uint16_t start = cpu->program_counter.word;
+    uint16_t end = cpu->jumpAddress;
+    // An interrupt taken straight after the jump leaves the program counter somewhere else entirely
+    if (cpu->halt or start > end or end >= 0x8000 or end - start >= kMaxLoopBytes or (start < 0x4000) != (end < 0x4000)
+        or mmu->BattleHooksActive()) {
+        tracking = false;
+        return;
+    }
+
+    unsigned int bank = start < 0x4000 ? 0 : mmu->CurrentRomBank();
+    auto state = CurrentState();
+    if (!tracking or start != loopStart or end != loopEnd or bank != loopBank) {
+        tracking = true;
+        loopBank = bank;
+        loopStart = start;
+        loopEnd = end;
+        loopInstructions = CountReadOnlyInstructions(start, end, bank);
+        lastState = state;
+        return;
+    }
+
+    // Idle if the iteration ran straight through (no interrupt) and left everything it could read as it was
+    bool idle = loopInstructions != 0
+                and state.instructions - lastState.instructions == loopInstructions
+                and state.registers == lastState.registers
+                and state.interruptMasterEnable == lastState.interruptMasterEnable
+                and state.interruptEnable == lastState.interruptEnable
+                and state.interruptFlag == lastState.interruptFlag
+                and state.divider == lastState.divider
+                and state.counter == lastState.counter
+                and state.scanline == lastState.scanline
+                and state.lcdStatus == lastState.lcdStatus;
+    auto iteration_cycles = state.clock - lastState.clock;
+    auto iteration_cb_instructions = state.cbInstructions - lastState.cbInstructions;
+    lastState = state;
+    if (!idle or iteration_cycles == 0) return;
+
+    auto& loop = loops[loopBank << 16 | loopStart];
+    loop.bank = loopBank;
+    loop.start = loopStart;
+    loop.end = loopEnd;
+
+    // Stop short of the end of the cycle budget, so GameBoy::RunUntil finishes it normally
+    if (cpu->clock + 1 >= cpu->frame_clock) return;
+    auto iterations = std::min(timer->CyclesUntilNextChange(), cpu->frame_clock - cpu->clock - 1) / iteration_cycles;
+    if (iterations == 0) return;
+
+    auto cycles = iterations * iteration_cycles;
+    cpu->clock += cycles;
+    timer->Skip(cycles);
+    counters->instructions += iterations * loopInstructions;
+    counters->cbInstructions += iterations * iteration_cb_instructions;
+    counters->idleCycles += cycles;
+
+    ++loop.skips;
+    loop.cycles += cycles;
+    cyclesSkipped += cycles;
+
+    lastState.clock = cpu->clock;
+    lastState.instructions = counters->instructions;
+    lastState.cbInstructions = counters->cbInstructions;
+}
+
+IdleLoopState IdleLoopDetector::CurrentState() const {
+    cpu->ResolveFlags();
+
+    IdleLoopState state;
+    state.registers = {{cpu->AF.word, cpu->BC.word, cpu->DE.word, cpu->HL.word, cpu->stack_pointer.word}};
+    state.interruptMasterEnable = cpu->interrupt_master_enable;
+    state.interruptEnable = mmu->interrupt_enable;
+    state.interruptFlag = mmu->interrupt_flag;
+    state.divider = timer->divider_clock;
+    state.counter = timer->counter_clock;
+    state.scanline = timer->scanline;
+    state.lcdStatus = mmu->zram[0xFF41&0xFF];
+    state.clock = cpu->clock;
+    state.instructions = counters->instructions;
+    state.cbInstructions = counters->cbInstructions;
+    return state;
+}
+
+/**
+ * Returns how many instructions the loop from start to the jump back at end runs, if they are all loads into A,
+ * arithmetic on A or BIT tests of values that stay the same between timer and LCD changes. Returns 0 otherwise,
+ * including for loops with any other jump in them.
+ *
+ * Addresses read through BC, DE or HL are taken from the registers now, which is safe as the loop can only write A.
+ */
+unsigned int IdleLoopDetector::CountReadOnlyInstructions(uint16_t start, uint16_t end, unsigned int bank) const {
+    auto rom = mmu->RomBank(bank);
+    unsigned int instructions = 0;
+    uint16_t address = start;
+    while (address < end) {
+        uint8_t opcode = rom[address & 0x3FFF];
+        uint8_t immediate = rom[(address + 1) & 0x3FFF];
+        unsigned int length = kOpcodes[opcode].length;
+        bool reads = false;
+        uint16_t read_address = 0;
+
+        if (opcode == 0x00 or (opcode >= 0x78 and opcode <= 0x7D) or opcode == 0x7F) {
+            // NOP, LD A,r
+        } else if (opcode >= 0x80 and opcode <= 0xBF) {
+            // ADD, ADC, SUB, SBC, AND, XOR, OR and CP with a register or (HL)
+            reads = (opcode & 0x07) == 0x06;
+            read_address = cpu->HL.word;
+        } else {
+            switch (opcode) {
+                case 0x0A: reads = true; read_address = cpu->BC.word; break; // LD A,(BC)
+                case 0x1A: reads = true; read_address = cpu->DE.word; break; // LD A,(DE)
+                case 0x7E: reads = true; read_address = cpu->HL.word; break; // LD A,(HL)
+                case 0xF2: reads = true; read_address = 0xFF00 + cpu->BC.lower; break; // LD A,(C)
+
+                // LD A,n and arithmetic with n
+                case 0x3E: case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+                    break;
+
+                case 0xF0: // LDH A,(n)
+                    reads = true;
+                    read_address = 0xFF00 + immediate;
+                    break;
+
+                case 0xFA: // LD A,(nn)
+                    reads = true;
+                    read_address = immediate | (rom[(address + 2) & 0x3FFF] << 8);
+                    break;
+
+                case 0xCB: // Only BIT
+                    if (immediate < 0x40 or immediate >= 0x80) return 0;
+                    reads = (immediate & 0x07) == 0x06;
+                    read_address = cpu->HL.word;
+                    break;
+
+                default:
+                    return 0;
+            }
+        }
+
+        if (reads and !StableRead(read_address)) return 0;
+        address += length;
+        ++instructions;
+    }
+
+    // The last instruction has to be the jump back itself, not the middle of one
+    if (address != end) return 0;
+    return instructions + 1;
+}
+
+/**
+ * Prints how many loops were found idle and how much of the emulated time skipping them saved running, most first.
+ */
+void IdleLoopDetector::Report(std::ostream& output, uint64_t total_cycles) const {
+    output << "Idle loops: " << loops.size() << " found, " << cyclesSkipped << " of " << total_cycles
+           << " cycles skipped (" << std::fixed << std::setprecision(1)
+           << (total_cycles ? 100.0 * cyclesSkipped / total_cycles : 0.0) << "%)" << std::endl;
+
+    std::vector<IdleLoop> sorted;
+    for (auto const& loop : loops) {
+        sorted.push_back(loop.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](IdleLoop const& left, IdleLoop const& right) {
+        return left.cycles > right.cycles;
+    });
+    for (auto const& loop : sorted) {
+        output << "  " << std::hex << std::setfill('0') << std::setw(2) << loop.bank << ":" << std::setw(4) << loop.start
+               << "-" << std::setw(4) << loop.end << std::dec << std::setfill(' ') << std::setw(10) << loop.skips
+               << " skips " << std::setw(12) << loop.cycles << " cycles" << std::endl;
+    }
+}
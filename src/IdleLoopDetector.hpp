@@ -0,0 +1,94 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_IDLELOOPDETECTOR_HPP
+#define GAMEBOYEMULATOR_IDLELOOPDETECTOR_HPP
+
+#include <stdint.h>
+#include <array>
+#include <map>
+#include <ostream>
+
+class Processor;
+class MemoryManagementUnit;
+class Timer;
+struct PerformanceCounters;
+
+/**
+ * What an idle loop could be waiting on, as of the end of one of its iterations.
+ */
+struct IdleLoopState {
+    std::array<uint16_t, 5> registers; // AF, BC, DE, HL and SP
+    uint8_t interruptMasterEnable;
+    uint8_t interruptEnable;
+    uint8_t interruptFlag;
+    uint8_t divider;
+    uint8_t counter;
+    uint8_t scanline;
+    uint8_t lcdStatus;
+    uint64_t clock;
+    uint64_t instructions;
+    uint64_t cbInstructions;
+};
+
+/**
+ * A loop found to be idle, and how much of it was skipped.
+ */
+struct IdleLoop {
+    unsigned int bank;
+    uint16_t start;
+    uint16_t end; // Address of the jump back to start
+    uint64_t skips = 0;
+    uint64_t cycles = 0; // Clocks/4 skipped
+};
+
+/**
+ * Finds loops that poll memory while waiting on the LCD, timers or an interrupt (LY, STAT or a flag a V-Blank handler
+ * sets), and skips them ahead to the next time anything they could read changes.
+ *
+ * A loop qualifies if it is a short run of ROM code, ending in a jump back to its start, that only loads into A, does
+ * arithmetic on A and tests bits. Once one whole iteration ends with every register, the interrupt registers and the
+ * timers' visible state as they were at its start, every following iteration will do the same until one of them
+ * changes. Those can only change on a timer, scanline or LCD mode change (each of which is reached by running normally),
+ * so as many whole iterations as fit before the next one are skipped by moving the clocks on.
+ */
+class IdleLoopDetector {
+public:
+    static uint16_t const kMaxLoopBytes = 16;
+
+    bool enabled;
+
+    IdleLoopDetector();
+
+    void Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Timer* timer_, PerformanceCounters* counters_);
+    void Reset();
+    void BeginRun();
+    void Update();
+
+    std::size_t LoopsFound() const {return loops.size();}
+    uint64_t CyclesSkipped() const {return cyclesSkipped;}
+    void Report(std::ostream& output, uint64_t total_cycles) const;
+
+private:
+    Processor* cpu;
+    MemoryManagementUnit* mmu;
+    Timer* timer;
+    PerformanceCounters* counters;
+
+    std::map<uint32_t, IdleLoop> loops; // By bank << 16 | start
+    uint64_t cyclesSkipped;
+
+    // The loop last jumped back to, which is idle once an iteration of it changes nothing
+    bool tracking;
+    unsigned int loopBank;
+    uint16_t loopStart;
+    uint16_t loopEnd;
+    unsigned int loopInstructions; // 0 if the loop does more than read
+    IdleLoopState lastState;
+
+    IdleLoopState CurrentState() const;
+    unsigned int CountReadOnlyInstructions(uint16_t start, uint16_t end, unsigned int bank) const;
+};
+
+#endif //GAMEBOYEMULATOR_IDLELOOPDETECTOR_HPP
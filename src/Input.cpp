@@ -11,16 +11,19 @@
 #include "Timer.hpp"
 #include "GameBoy.hpp"
 #include "Network.hpp"
+#include "Movie.hpp"
 
 #include "serq.hpp"
 
 Input::Input()
-	: current_save_slot(1) {
+	: headless(false)
+	, current_save_slot(1) {
+    keysHeld.fill(false);
     Reset();
 }
 
 void Input::Initialize(MemoryManagementUnit* mmu_, Display* display_, 
-				       Timer* timer_, Processor* cpu_, GameBoy* gameboy_, Network* network_, sf::RenderWindow* window_) {
+				       Timer* timer_, Processor* cpu_, GameBoy* gameboy_, Network* network_, Movie* movie_, sf::RenderWindow* window_) {
     mmu = mmu_;
 	display = display_;
 	timer = timer_;
@@ -28,6 +31,7 @@ void Input::Initialize(MemoryManagementUnit* mmu_, Display* display_,
     window = window_;
     gameboy = gameboy_;
     network = network_;
+    movie = movie_;
 }
 
 /**
@@ -99,14 +103,43 @@ void Input::KeyDown(KeyType key) {
 }
 
 /**
- * Handles user inputs such as close window and resize window.
+ * Returns the state of every key in one byte, the low nybble holding A, B, Select and Start and the high nybble Right,
+ * Left, Up and Down (0 = pressed).
+ */
+uint8_t Input::JoypadState() const {
+    return (rows[0] & 0x0F) | ((rows[1] & 0x0F) << 4);
+}
+
+/**
+ * Sets every key at once from a JoypadState. Unlike KeyDown, doesn't raise the joypad interrupt.
+ */
+void Input::SetJoypadState(uint8_t state) {
+    rows[0] = state & 0x0F;
+    rows[1] = (state >> 4) & 0x0F;
+}
+
+/**
+ * Queues an event from the window, for the emulation thread to handle at the start of its next frame (PollEvents).
+ * The window's events can only be polled on the thread that created it.
+ */
+void Input::QueueEvent(sf::Event const& event) {
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    queuedEvents.push_back(event);
+}
+
+/**
+ * Handles the user inputs queued since the last frame. Returns false if the window was closed.
  */
 bool Input::PollEvents() {
-    sf::Event event;
-	sf::Image screenshot;
-    while (window->pollEvent(event)) {
+    if (headless) return true;
+    
+    std::vector<sf::Event> events;
+    {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        events.swap(queuedEvents);
+    }
+    for (auto const& event : events) {
         if (event.type == sf::Event::Closed) {
-            window->close();
             return false;
         } else if (event.type == sf::Event::KeyPressed) {
             int tempTalkingWithPlayer = -1;
@@ -159,11 +192,7 @@ bool Input::PollEvents() {
 					LoadGameState(current_save_slot);
 					break;	
 					
-				// Print screen (for some reason PrintScrn isn't support by SFML	
-				case sf::Keyboard::P:
-					screenshot = window->capture();
-					screenshot.saveToFile(mmu->game_title + ".png");
-					break;
+				// Print screen (P) is handled by the window's thread, which can capture it
 					
 				// Print Screen (original resolution)	
 				case sf::Keyboard::O:
@@ -190,6 +219,13 @@ bool Input::PollEvents() {
 				
 					break;
                     
+#ifdef POKESYNCH_PROFILER
+                // Toggle the profiler overlay
+                case sf::Keyboard::F3:
+                    gameboy->profiler.showOverlay = !gameboy->profiler.showOverlay;
+                    break;
+#endif
+                    
                 // Initiate a battle (TODO: TESTING)
                 case sf::Keyboard::B:
                     gameboy->initiateBattleFlag = true;
@@ -299,73 +335,43 @@ void Input::UpdateInput() {
     // Ignore joystick input while in special dialogue
     if (dialogueWithPlayer != PlayerDialogue::NOT_IN_DIALOGUE) return;
     
-    static bool left = false;
-    static bool right = false;
-    static bool up = false;
-    static bool down = false;
-    static bool a = false;
-    static bool b = false;
-    static bool start = false;
-    static bool select = false;
+    // A replayed movie replaces the keyboard entirely
+    if (movie->IsReplaying()) {
+        movie->ReplayInput();
+        return;
+    }
+    
+    // Headless instances have no keyboard, their input comes from KeyDown/KeyUp
+    if (headless) return;
 
     // Read button states
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) and !left) {
-        KeyDown(KeyType::LEFT);
-        left = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Left) and left) {
-        KeyUp(KeyType::LEFT);
-        left = false;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) and !right) {
-        KeyDown(KeyType::RIGHT);
-        right = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Right) and right) {
-        KeyUp(KeyType::RIGHT);
-        right = false;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up) and !up) {
-        KeyDown(KeyType::UP);
-        up = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Up) and up) {
-        KeyUp(KeyType::UP);
-        up = false;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down) and !down) {
-        KeyDown(KeyType::DOWN);
-        down = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Down) and down) {
-        KeyUp(KeyType::DOWN);
-        down = false;
-    }
+    UpdateKey(sf::Keyboard::Left, KeyType::LEFT);
+    UpdateKey(sf::Keyboard::Right, KeyType::RIGHT);
+    UpdateKey(sf::Keyboard::Up, KeyType::UP);
+    UpdateKey(sf::Keyboard::Down, KeyType::DOWN);
     if (!ignoreA) {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::X) and !a) {
-            KeyDown(KeyType::A);
-            a = true;
-        } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::X) and a) {
-            KeyUp(KeyType::A);
-            a = false;
-        }
+        UpdateKey(sf::Keyboard::X, KeyType::A);
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Z) and !b) {
-        KeyDown(KeyType::B);
-        b = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Z) and b) {
-        KeyUp(KeyType::B);
-        b = false;
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Return) and !start) {
-        KeyDown(KeyType::START);
-        start = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Return) and start) {
-        KeyUp(KeyType::START);
-        start = false;
+    UpdateKey(sf::Keyboard::Z, KeyType::B);
+    UpdateKey(sf::Keyboard::Return, KeyType::START);
+    UpdateKey(sf::Keyboard::RShift, KeyType::SELECT);
+    
+    if (movie->IsRecording()) {
+        movie->RecordInput();
     }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::RShift) and !select) {
-        KeyDown(KeyType::SELECT);
-        select = true;
-    } else if (!sf::Keyboard::isKeyPressed(sf::Keyboard::RShift) and select) {
-        KeyUp(KeyType::SELECT);
-        select = false;
+}
+
+/**
+ * Presses or releases the joypad key if the keyboard key mapped to it changed state since the last update.
+ */
+void Input::UpdateKey(sf::Keyboard::Key keyboardKey, KeyType key) {
+    bool& held = keysHeld[static_cast<int>(key)];
+    if (sf::Keyboard::isKeyPressed(keyboardKey) and !held) {
+        KeyDown(key);
+        held = true;
+    } else if (!sf::Keyboard::isKeyPressed(keyboardKey) and held) {
+        KeyUp(key);
+        held = false;
     }
 }
 
@@ -374,7 +380,13 @@ void Input::UpdateInput() {
  */
 void Input::SaveGameState(int save_slot) {
 	// Save file format: GAMENAME_SLOTNUMBER.gbs
-	
+	SaveGameState(mmu->game_title + std::string("_") + std::to_string(save_slot) + std::string(".gbs"));
+}
+
+/**
+ * Saves game by serializing game state to the given file.
+ */
+void Input::SaveGameState(std::string const& save_name) {
 	// Serialize game state
 	serq::SerializeQueue save_data;
 	
@@ -454,6 +466,7 @@ void Input::SaveGameState(int save_slot) {
 	save_data.push<uint64_t>(timer->v_blank_triggered?1:0);
 	
 	// Processor
+	cpu->ResolveFlags();
 	save_data.push<uint64_t>(cpu->AF.word);
 	save_data.push<uint64_t>(cpu->AF_stack.word);
 	save_data.push<uint64_t>(cpu->BC.word);
@@ -470,8 +483,6 @@ void Input::SaveGameState(int save_slot) {
 	save_data.push<uint64_t>(cpu->clock);
 	save_data.push<uint64_t>(cpu->m_clock);
 	
-	std::string save_name = mmu->game_title + std::string("_") 
-							+ std::to_string(save_slot) + std::string(".gbs");
 	save_data.Serialize(save_name); // Todo: May want to differentiate by version number also to prevent incompatibilities (0x014C)
 }
 
@@ -498,11 +509,15 @@ void Input::SaveCharVector(serq::SerializeQueue& save_data, std::vector<uint8_t>
  */
 void Input::LoadGameState(int save_slot) {
 	// Load file format: GAMENAME_SLOTNUMBER.gbs
-	
+	LoadGameState(mmu->game_title + std::string("_") + std::to_string(save_slot) + std::string(".gbs"));
+}
+
+/**
+ * Loads game state from the given file.
+ */
+void Input::LoadGameState(std::string const& save_name) {
 	// Deserialize game state
     serq::SerializeQueue save_data;
-	std::string save_name = mmu->game_title + std::string("_") 
-							+ std::to_string(save_slot) + std::string(".gbs");
 	save_data.Deserialize(save_name);
 	
 	// Cartridge Header
@@ -581,6 +596,7 @@ void Input::LoadGameState(int save_slot) {
 	timer->v_blank_triggered = save_data.pop<uint64_t>()?true:false;
 	
 	// Processor
+	cpu->ResolveFlags(); // Drops any pending flags so the loaded F register is used
 	cpu->AF.word = save_data.pop<uint64_t>();
 	cpu->AF_stack.word = save_data.pop<uint64_t>();
 	cpu->BC.word = save_data.pop<uint64_t>();
@@ -12,6 +12,8 @@
 #include <SFML/System.hpp>
 
 #include <array>
+#include <mutex>
+#include <vector>
 
 namespace serq {
 	class SerializeQueue;
@@ -49,6 +51,7 @@ class Timer;
 class Processor;
 class GameBoy;
 class Network;
+class Movie;
 
 /**
  * Handles input for game (joypad).
@@ -58,18 +61,23 @@ public:
     Input();
 
     void Initialize(MemoryManagementUnit* mmu_, Display* display_, 
-				    Timer* timer_, Processor* cpu_,  GameBoy* gameboy_, Network* network_, sf::RenderWindow* window_);
+				    Timer* timer_, Processor* cpu_,  GameBoy* gameboy_, Network* network_, Movie* movie_, sf::RenderWindow* window_);
     void Reset();
     uint8_t ReadByte();
     void WriteByte(uint8_t value);
 
+    void QueueEvent(sf::Event const& event);
     bool PollEvents();
     void UpdateInput();
     void KeyUp(KeyType key);
     void KeyDown(KeyType key);
+    uint8_t JoypadState() const;
+    void SetJoypadState(uint8_t state);
 	
 	void SaveGameState(int save_slot);
+	void SaveGameState(std::string const& save_name);
 	void LoadGameState(int save_slot);
+	void LoadGameState(std::string const& save_name);
     
     bool initiateBattleFlag;
     
@@ -78,6 +86,8 @@ public:
     int talkingWithPlayer;
     int currentSelection; // Selection in current menu, 0 = first, 1 = second, etc
     bool ignoreA;
+    
+    bool headless; // No window or keyboard, used when running many instances in one process
 
 private:
     MemoryManagementUnit* mmu;
@@ -86,16 +96,22 @@ private:
 	Processor* cpu;
 	GameBoy* gameboy;
     Network* network;
+    Movie* movie;
     sf::RenderWindow* window;
+    
+    std::mutex eventsMutex;
+    std::vector<sf::Event> queuedEvents; // From the window's thread, handled by PollEvents
 
     std::array<uint8_t, 2> rows;
     uint8_t column;
+    std::array<bool, 8> keysHeld; // Keyboard state from the last UpdateInput, indexed by KeyType
 	
 	int current_save_slot;
     
     std::array<uint8_t, 0x194> pokemonParty;
 	
 	// Helper Function
+    void UpdateKey(sf::Keyboard::Key keyboardKey, KeyType key);
 	void SaveCharVector(serq::SerializeQueue& save_data, std::vector<uint8_t>& data, std::size_t length);
 	void LoadCharVector(serq::SerializeQueue& save_data, std::vector<uint8_t>& data, std::size_t length);
 };
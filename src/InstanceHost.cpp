@@ -0,0 +1,206 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "InstanceHost.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// How far an instance can fall behind its deadline before its late frames are dropped instead of run back to back
+std::chrono::nanoseconds const kMaxFrameLag = 4*kFrameDuration;
+
+InstanceHost::InstanceHost(std::size_t numberOfInstances, std::size_t numberOfThreads)
+    : numberOfThreads(std::max<std::size_t>(numberOfThreads, 1))
+    , running(false) {
+    for (std::size_t index = 0; index < numberOfInstances; ++index) {
+        std::unique_ptr<HostedInstance> instance(new HostedInstance());
+        instance->gameboy.reset(new GameBoy());
+        instances.push_back(std::move(instance));
+    }
+}
+
+InstanceHost::~InstanceHost() {
+    Stop();
+}
+
+/**
+ * Loads the game into every instance. Each instance starts from the given save (if any) but writes back to its own
+ * GAMETITLE_INDEX.sav.
+ */
+void InstanceHost::LoadGame(std::string rom_name, std::string save_file) {
+    for (std::size_t index = 0; index < instances.size(); ++index) {
+        auto& gameboy = *instances[index]->gameboy;
+        gameboy.LoadGame(rom_name, save_file);
+        gameboy.mmu.save_name = gameboy.mmu.game_title + "_" + std::to_string(index) + ".sav";
+    }
+}
+
+/**
+ * Connects every instance to the session, instance N listening on port + N.
+ */
+void InstanceHost::StartNetwork(std::string name, unsigned short port, std::string ipAddress, unsigned short hostPort) {
+    for (std::size_t index = 0; index < instances.size(); ++index) {
+        instances[index]->gameboy->StartNetwork(name + std::to_string(index), port + index, ipAddress, hostPort);
+    }
+}
+
+/**
+ * Schedules every instance's first frame for now and starts the worker threads.
+ */
+void InstanceHost::Start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& instance : instances) {
+        instance->deadline = now + kFrameDuration;
+        schedule.push(instance.get());
+    }
+    for (std::size_t thread = 0; thread < numberOfThreads; ++thread) {
+        workers.emplace_back(&InstanceHost::Worker, this);
+    }
+}
+
+/**
+ * Stops the workers once they finish the frames they're running.
+ */
+void InstanceHost::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    scheduleChanged.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    schedule = decltype(schedule)();
+}
+
+/**
+ * Repeatedly takes the instance with the earliest deadline, waits until its frame is due, and runs it.
+ */
+void InstanceHost::Worker() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (schedule.empty()) {
+            scheduleChanged.wait(lock);
+            continue;
+        }
+
+        // A frame is due one frame before its deadline; another worker may take it (or an earlier one) while waiting
+        HostedInstance* instance = schedule.top();
+        auto due = instance->deadline - kFrameDuration;
+        if (std::chrono::steady_clock::now() < due) {
+            scheduleChanged.wait_until(lock, due);
+            continue;
+        }
+        schedule.pop();
+        lock.unlock();
+
+        auto cpuStart = ThreadCpuTime();
+        instance->gameboy->RenderFrame();
+        auto cpuTime = ThreadCpuTime() - cpuStart;
+        auto finished = std::chrono::steady_clock::now();
+
+        lock.lock();
+        auto& stats = instance->stats;
+        ++stats.frames;
+        stats.cpuTime += cpuTime;
+        stats.maxFrameCpuTime = std::max(stats.maxFrameCpuTime, cpuTime);
+        if (finished > instance->deadline) {
+            ++stats.missedDeadlines;
+        }
+
+        instance->deadline += kFrameDuration;
+        if (finished - instance->deadline > kMaxFrameLag) {
+            // Too far behind to catch up, skip ahead to the next frame that can still be on time
+            auto framesBehind = (finished - instance->deadline) / kFrameDuration + 1;
+            stats.droppedFrames += framesBehind;
+            instance->deadline += framesBehind*kFrameDuration;
+        }
+
+        schedule.push(instance);
+        scheduleChanged.notify_one();
+    }
+}
+
+InstanceStats InstanceHost::Stats(std::size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return instances[index]->stats;
+}
+
+/**
+ * Returns the stats of every instance added together (maxFrameCpuTime is the worst frame of any instance).
+ */
+InstanceStats InstanceHost::TotalStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    InstanceStats total;
+    for (auto& instance : instances) {
+        total.frames += instance->stats.frames;
+        total.missedDeadlines += instance->stats.missedDeadlines;
+        total.droppedFrames += instance->stats.droppedFrames;
+        total.cpuTime += instance->stats.cpuTime;
+        total.maxFrameCpuTime = std::max(total.maxFrameCpuTime, instance->stats.maxFrameCpuTime);
+    }
+    return total;
+}
+
+/**
+ * Returns how many instances one core could keep running in real time, based on the average CPU time of a frame so
+ * far. Returns 0 until a frame has been run.
+ */
+double InstanceHost::RealTimeInstancesPerCore() {
+    auto total = TotalStats();
+    if (total.frames == 0 or total.cpuTime.count() == 0) return 0.0;
+
+    double cpuTimePerFrame = static_cast<double>(total.cpuTime.count()) / total.frames;
+    return kFrameDuration.count() / cpuTimePerFrame;
+}
+
+/**
+ * Prints the totals for all instances and the estimated number of real-time instances per core.
+ */
+void InstanceHost::Report(std::ostream& output) {
+    auto total = TotalStats();
+    double framesRun = std::max<double>(total.frames, 1);
+
+    output << std::fixed << std::setprecision(3)
+           << "Instances: " << instances.size() << " on " << numberOfThreads << " threads"
+           << "\tFrames: " << total.frames
+           << "\tMissed deadlines: " << total.missedDeadlines << " (" << 100.0*total.missedDeadlines/framesRun << "%)"
+           << "\tDropped frames: " << total.droppedFrames << std::endl
+           << "CPU per frame: " << total.cpuTime.count()/framesRun/1e6 << "ms average, "
+           << total.maxFrameCpuTime.count()/1e6 << "ms worst"
+           << "\tReal-time instances per core: " << RealTimeInstancesPerCore() << std::endl;
+}
+
+/**
+ * Returns the CPU time used so far by the calling thread, or wall time if the platform can't measure it.
+ */
+std::chrono::nanoseconds InstanceHost::ThreadCpuTime() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        uint64_t kernelTime = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+        uint64_t userTime = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+        return std::chrono::nanoseconds((kernelTime + userTime)*100); // FILETIME counts in 100ns intervals
+    }
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0) {
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    }
+#endif
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+}
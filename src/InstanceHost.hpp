@@ -0,0 +1,87 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_INSTANCEHOST_HPP
+#define GAMEBOYEMULATOR_INSTANCEHOST_HPP
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameBoy.hpp"
+
+// Time between frames, matching the pacing of the windowed frontend
+std::chrono::nanoseconds const kFrameDuration(16750419);
+
+/**
+ * Accounting for one (or the sum of several) instances run by an InstanceHost.
+ */
+struct InstanceStats {
+    uint64_t frames = 0;
+    uint64_t missedDeadlines = 0; // Frames that finished after their deadline
+    uint64_t droppedFrames = 0; // Frames skipped entirely after falling too far behind
+    std::chrono::nanoseconds cpuTime{0}; // CPU time spent by worker threads emulating the instance
+    std::chrono::nanoseconds maxFrameCpuTime{0};
+};
+
+/**
+ * Runs many headless GameBoys in one process on a fixed number of worker threads.
+ *
+ * Every instance has its own frame deadline, one kFrameDuration after the last, and the workers always run whichever
+ * instance's frame is due soonest. Instances share the process's copy of the ROM (see RomImage), and each gets its own
+ * .sav file so they don't overwrite one another.
+ */
+class InstanceHost {
+public:
+    InstanceHost(std::size_t numberOfInstances, std::size_t numberOfThreads);
+    ~InstanceHost();
+
+    void LoadGame(std::string rom_name, std::string save_file);
+    void StartNetwork(std::string name, unsigned short port, std::string ipAddress, unsigned short hostPort);
+    void Start();
+    void Stop();
+    void Report(std::ostream& output);
+
+    // Only safe to use while the host is stopped
+    GameBoy& Instance(std::size_t index) {return *instances[index]->gameboy;}
+    std::size_t NumberOfInstances() const {return instances.size();}
+
+    InstanceStats Stats(std::size_t index);
+    InstanceStats TotalStats();
+    double RealTimeInstancesPerCore();
+
+    static std::chrono::nanoseconds ThreadCpuTime(); // Also times the relay server's ticks
+
+private:
+    struct HostedInstance {
+        std::unique_ptr<GameBoy> gameboy;
+        std::chrono::steady_clock::time_point deadline;
+        InstanceStats stats;
+    };
+
+    struct LaterDeadline {
+        bool operator()(HostedInstance const* a, HostedInstance const* b) const {return a->deadline > b->deadline;}
+    };
+
+    std::vector<std::unique_ptr<HostedInstance>> instances;
+    std::size_t numberOfThreads;
+    std::vector<std::thread> workers;
+
+    // Instances waiting on their next frame, earliest deadline first (instances being run by a worker aren't in it)
+    std::priority_queue<HostedInstance*, std::vector<HostedInstance*>, LaterDeadline> schedule;
+    std::mutex mutex; // Guards schedule, running and every instance's deadline and stats
+    std::condition_variable scheduleChanged;
+    bool running;
+
+    void Worker();
+};
+
+#endif //GAMEBOYEMULATOR_INSTANCEHOST_HPP
@@ -0,0 +1,149 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "LinkStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+    double Milliseconds(std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    /**
+     * How far after other the sequence number is, allowing for it wrapping.
+     */
+    int32_t SequenceDistance(uint32_t sequence, uint32_t other) {
+        return static_cast<int32_t>(sequence - other);
+    }
+}
+
+uint32_t LinkClock() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+void SendTimes::Record(uint32_t sequence, std::chrono::steady_clock::time_point sentAt) {
+    auto& slot = sent[sequence % kSize];
+    slot.sequence = sequence;
+    slot.at = sentAt;
+}
+
+/**
+ * Returns false if the packet was never recorded or has been overwritten since.
+ */
+bool SendTimes::Find(uint32_t sequence, std::chrono::steady_clock::time_point& sentAt) const {
+    auto const& slot = sent[sequence % kSize];
+    if (sequence == 0 or slot.sequence != sequence) return false;
+    sentAt = slot.at;
+    return true;
+}
+
+/**
+ * Counts a numbered packet from the peer, measuring loss, reordering and jitter with it. Unnumbered ones are ignored.
+ */
+void LinkStats::Received(PacketNumber const& number, std::chrono::steady_clock::time_point receivedAt) {
+    if (number.sequence == 0) return;
+
+    if (highestSequence == 0) {
+        firstSequence = highestSequence = number.sequence;
+        highestReceived = receivedAt;
+        recentSequences.set(0);
+    } else {
+        auto distance = SequenceDistance(number.sequence, highestSequence);
+        if (distance > 0) {
+            recentSequences = distance < 128 ? recentSequences << distance : std::bitset<128>();
+            recentSequences.set(0);
+            highestSequence = number.sequence;
+            highestReceived = receivedAt;
+        } else if (-distance < 128 and recentSequences.test(-distance)) {
+            ++packetsDuplicated;
+            return;
+        } else {
+            // Too old to tell whether it's a duplicate is counted as reordered, which it almost certainly is as well
+            if (-distance < 128) recentSequences.set(-distance);
+            if (SequenceDistance(number.sequence, firstSequence) < 0) firstSequence = number.sequence;
+            ++packetsReordered;
+        }
+
+        // How much longer (or shorter) the gap between the last two packets was on arrival than when sent
+        auto transit = std::chrono::duration_cast<std::chrono::microseconds>(receivedAt - lastArrival).count()
+                     - static_cast<int32_t>(number.sentAt - lastSentAt);
+        jitter += (std::abs(transit) / 1000.0 - jitter) / 16;
+    }
+
+    ++packetsReceived;
+    lastSentAt = number.sentAt;
+    lastArrival = receivedAt;
+    lastReceived = receivedAt;
+}
+
+/**
+ * Takes a round trip sample from an echo of a packet sent at sentAt, received back at receivedAt.
+ */
+void LinkStats::RoundTrip(std::chrono::steady_clock::time_point sentAt, LinkEcho const& echo,
+                          std::chrono::steady_clock::time_point receivedAt) {
+    auto sample = Milliseconds(receivedAt - sentAt) - echo.delay / 1000.0;
+    if (sample < 0) return; // Held longer than the whole trip took, so the echo is from some other packet
+
+    if (roundTrips == 0) {
+        roundTrip = minRoundTrip = sample;
+        roundTripVariance = sample / 2;
+    } else {
+        roundTripVariance += (std::abs(roundTrip - sample) - roundTripVariance) / 4;
+        roundTrip += (sample - roundTrip) / 8;
+        minRoundTrip = std::min(minRoundTrip, sample);
+    }
+    ++roundTrips;
+}
+
+/**
+ * The echo to send back to the peer now.
+ */
+LinkEcho LinkStats::Echo(std::chrono::steady_clock::time_point now) const {
+    if (highestSequence == 0) return {0, 0};
+    auto delay = std::chrono::duration_cast<std::chrono::microseconds>(now - highestReceived).count();
+    return {highestSequence, static_cast<uint32_t>(delay)};
+}
+
+/**
+ * How many numbered packets should have arrived, going by the first and highest sequence numbers.
+ */
+uint64_t LinkStats::PacketsExpected() const {
+    if (highestSequence == 0) return 0;
+    return static_cast<uint32_t>(highestSequence - firstSequence) + 1ull;
+}
+
+/**
+ * Numbered packets that never arrived, less any that arrived late.
+ */
+uint64_t LinkStats::PacketsLost() const {
+    auto expected = PacketsExpected();
+    return expected > packetsReceived ? expected - packetsReceived : 0;
+}
+
+/**
+ * Prints the link's round trip and jitter, and its loss, reordering and byte rates over the seconds since it was as
+ * since is.
+ */
+void LinkStats::Write(std::ostream& output, LinkStats const& since, double seconds) const {
+    seconds = std::max(seconds, 1e-3);
+    auto expected = PacketsExpected() - since.PacketsExpected();
+    auto lost = std::max<int64_t>(PacketsLost() - since.PacketsLost(), 0);
+
+    output << std::fixed << std::setprecision(2);
+    if (roundTrips > 0) {
+        output << "RTT: " << roundTrip << "ms (min " << minRoundTrip << "ms, deviation " << roundTripVariance << "ms)";
+    } else {
+        output << "RTT: unknown";
+    }
+    output << "\tJitter: " << jitter << "ms"
+           << "\tLost: " << lost << " of " << expected << " (" << lost * 100.0 / std::max<uint64_t>(expected, 1) << "%)"
+           << "\tReordered: " << packetsReordered - since.packetsReordered
+           << "\tDuplicated: " << packetsDuplicated - since.packetsDuplicated
+           << "\tIn: " << (bytesIn - since.bytesIn) / seconds / 1024 << "KB/s"
+           << "\tOut: " << (bytesOut - since.bytesOut) / seconds / 1024 << "KB/s" << std::endl;
+}
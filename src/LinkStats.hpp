@@ -0,0 +1,92 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_LINKSTATS_HPP
+#define GAMEBOYEMULATOR_LINKSTATS_HPP
+
+#include <stdint.h>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <ostream>
+
+/**
+ * Numbers a packet in its sender's stream of them, so whoever receives it can tell which were lost, which arrived out of
+ * order, and how much their spacing changed on the way (see LinkStats).
+ */
+struct PacketNumber {
+    uint32_t sequence; // From 1, 0 for a packet that isn't numbered
+    uint32_t sentAt; // The sender's clock (see LinkClock), which only means something next to its other packets' sentAt
+};
+
+/**
+ * Sent back to whoever numbered the packets: the latest of their sequence numbers received, and how long ago it was
+ * received. The round trip is how long ago they sent it, less that delay.
+ */
+struct LinkEcho {
+    uint32_t sequence; // 0 when nothing numbered has been received yet
+    uint32_t delay; // Microseconds
+};
+
+/**
+ * A steady clock in microseconds, wrapping every 71 minutes, for PacketNumber::sentAt.
+ */
+uint32_t LinkClock();
+
+/**
+ * When each of the last kSize numbered packets was sent, to work out round trips from the LinkEchoes sent back.
+ */
+class SendTimes {
+public:
+    static std::size_t const kSize = 256; // Over 50 seconds of game states, far longer than any round trip worth measuring
+
+    void Record(uint32_t sequence, std::chrono::steady_clock::time_point sentAt);
+    bool Find(uint32_t sequence, std::chrono::steady_clock::time_point& sentAt) const;
+
+private:
+    struct Sent {
+        uint32_t sequence = 0;
+        std::chrono::steady_clock::time_point at;
+    };
+    std::array<Sent, kSize> sent;
+};
+
+/**
+ * The quality of the link to one peer, from the numbered packets they send and the round trips measured from their
+ * echoes: loss and reordering by sequence number, interarrival jitter as RTP measures it (RFC 3550), the round trip
+ * smoothed as TCP does (RFC 6298), and the bytes each way.
+ *
+ * Rates aren't kept, just totals, so they're worked out over whatever interval the stats are looked at (see Write).
+ */
+struct LinkStats {
+    uint64_t packetsReceived = 0; // Numbered ones, not counting duplicates
+    uint64_t packetsReordered = 0; // Arrived after one numbered later
+    uint64_t packetsDuplicated = 0;
+    uint64_t bytesIn = 0; // Every packet from the peer, numbered or not
+    uint64_t bytesOut = 0;
+    uint64_t roundTrips = 0; // Samples taken
+    double roundTrip = 0; // Smoothed, in milliseconds
+    double roundTripVariance = 0; // Smoothed mean deviation, in milliseconds
+    double minRoundTrip = 0; // Milliseconds
+    double jitter = 0; // Milliseconds
+    std::chrono::steady_clock::time_point lastReceived; // Numbered packets only
+
+    void Received(PacketNumber const& number, std::chrono::steady_clock::time_point receivedAt);
+    void RoundTrip(std::chrono::steady_clock::time_point sentAt, LinkEcho const& echo, std::chrono::steady_clock::time_point receivedAt);
+    LinkEcho Echo(std::chrono::steady_clock::time_point now) const;
+
+    uint64_t PacketsExpected() const;
+    uint64_t PacketsLost() const;
+    void Write(std::ostream& output, LinkStats const& since, double seconds) const;
+
+private:
+    uint32_t firstSequence = 0;
+    uint32_t highestSequence = 0; // 0 until the first numbered packet
+    std::chrono::steady_clock::time_point highestReceived;
+    uint32_t lastSentAt = 0; // For jitter, of the packet received before
+    std::chrono::steady_clock::time_point lastArrival;
+    std::bitset<128> recentSequences; // Bit n is whether highestSequence - n was received, to spot duplicates
+};
+
+#endif //GAMEBOYEMULATOR_LINKSTATS_HPP
@@ -0,0 +1,155 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "LoopbackTransport.hpp"
+
+#include <algorithm>
+
+namespace {
+    unsigned short const kFirstEphemeralPort = 49152;
+
+    /**
+     * Orders a heap of datagrams in flight with the next due at the front.
+     */
+    struct LaterDelivery {
+        template <typename InFlight>
+        bool operator()(InFlight const& left, InFlight const& right) const {
+            if (left.deliverAt != right.deliverAt) return left.deliverAt > right.deliverAt;
+            return left.order > right.order;
+        }
+    };
+}
+
+LoopbackNetwork::LoopbackNetwork(uint32_t seed)
+    : random(seed)
+    , sent(0)
+    , nextEphemeralPort(kFirstEphemeralPort) {
+}
+
+/**
+ * Changes the conditions for datagrams sent from now on. Those in flight arrive as they were going to.
+ */
+void LoopbackNetwork::SetConditions(LinkConditions const& conditions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->conditions = conditions;
+}
+
+LoopbackStats LoopbackNetwork::Stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+/**
+ * Binds the transport to the port, or any free one if it's 0 (setting port to it). Returns false if it's taken.
+ */
+bool LoopbackNetwork::Bind(LoopbackTransport* transport, unsigned short& port) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (port == 0) {
+        while (ports.count(nextEphemeralPort)) {
+            nextEphemeralPort = nextEphemeralPort == 0xFFFF ? kFirstEphemeralPort : nextEphemeralPort + 1;
+        }
+        port = nextEphemeralPort;
+    }
+    return ports.emplace(port, transport).second;
+}
+
+void LoopbackNetwork::Unbind(unsigned short port) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ports.erase(port);
+}
+
+/**
+ * Puts a copy of the datagram in flight to whoever is bound to the port, unless it's lost on the way.
+ */
+void LoopbackNetwork::Send(unsigned short senderPort, void const* data, std::size_t size, unsigned short port) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.sent;
+    stats.bytes += size;
+
+    auto destination = ports.find(port);
+    if (destination == ports.end()) {
+        ++stats.unreachable;
+        return;
+    }
+    std::uniform_real_distribution<double> chance(0, 1);
+    if (conditions.loss > 0 and chance(random) < conditions.loss) {
+        ++stats.lost;
+        return;
+    }
+
+    auto delay = conditions.latency;
+    if (conditions.jitter.count() > 0) {
+        std::uniform_int_distribution<int64_t> jitter(-conditions.jitter.count(), conditions.jitter.count());
+        delay += std::chrono::microseconds(jitter(random));
+    }
+    if (conditions.reorder > 0 and chance(random) < conditions.reorder) {
+        delay += conditions.reorderDelay;
+        ++stats.reordered;
+    }
+
+    auto& inFlight = destination->second->inFlight;
+    auto bytes = static_cast<char const*>(data);
+    inFlight.push_back({std::chrono::steady_clock::now() + std::max(delay, std::chrono::microseconds(0)), sent++, senderPort,
+                        std::vector<char>(bytes, bytes + size)});
+    std::push_heap(inFlight.begin(), inFlight.end(), LaterDelivery());
+}
+
+LoopbackTransport::LoopbackTransport(LoopbackNetwork& network)
+    : network(network)
+    , port(0) {
+}
+
+LoopbackTransport::~LoopbackTransport() {
+    if (port != 0) {
+        network.Unbind(port);
+    }
+}
+
+bool LoopbackTransport::Bind(unsigned short port) {
+    if (this->port != 0) {
+        network.Unbind(this->port);
+        this->port = 0;
+    }
+    if (!network.Bind(this, port)) return false;
+    this->port = port;
+    return true;
+}
+
+/**
+ * Sends to the port on the loopback network, whatever the address. Like UDP, a datagram that's lost was still sent.
+ */
+sf::Socket::Status LoopbackTransport::Send(sf::Packet& packet, sf::IpAddress const& /*address*/, unsigned short port) {
+    if (this->port == 0) return sf::Socket::Error;
+    network.Send(this->port, packet.getData(), packet.getDataSize(), port);
+    return sf::Socket::Done;
+}
+
+/**
+ * Receives every datagram that's due by now, into datagrams from the front (reusing their buffers), and returns how many.
+ */
+std::size_t LoopbackTransport::ReceiveBatch(std::vector<ReceivedDatagram>& datagrams) {
+    auto now = std::chrono::steady_clock::now();
+    std::size_t count = 0;
+    std::lock_guard<std::mutex> lock(network.mutex);
+    while (!inFlight.empty() and inFlight.front().deliverAt <= now) {
+        std::pop_heap(inFlight.begin(), inFlight.end(), LaterDelivery());
+        auto& arrived = inFlight.back();
+        if (datagrams.size() <= count) datagrams.emplace_back();
+        auto& datagram = datagrams[count++];
+        datagram.packet.clear();
+        datagram.packet.append(arrived.data.data(), arrived.data.size());
+        datagram.sender = sf::IpAddress::LocalHost;
+        datagram.port = arrived.senderPort;
+        inFlight.pop_back();
+    }
+    return count;
+}
+
+std::size_t LoopbackTransport::SendToAll(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) {
+    std::size_t sent = 0;
+    for (auto const& destination : destinations) {
+        if (Send(packet, destination.address, destination.port) == sf::Socket::Done) ++sent;
+    }
+    return sent;
+}
@@ -0,0 +1,107 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_LOOPBACKTRANSPORT_HPP
+#define GAMEBOYEMULATOR_LOOPBACKTRANSPORT_HPP
+
+#include <stdint.h>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Transport.hpp"
+
+class LoopbackTransport;
+
+/**
+ * What every datagram crossing a LoopbackNetwork goes through. Each is delayed by the latency plus or minus up to the
+ * jitter (evenly spread), and with the given chances is dropped, or held back by reorderDelay more so it arrives after
+ * those sent behind it.
+ */
+struct LinkConditions {
+    std::chrono::microseconds latency{0};
+    std::chrono::microseconds jitter{0};
+    double loss = 0; // 0 to 1
+    double reorder = 0; // 0 to 1
+    std::chrono::microseconds reorderDelay{20000};
+};
+
+/**
+ * Counts of what a LoopbackNetwork did with the datagrams sent across it.
+ */
+struct LoopbackStats {
+    uint64_t sent = 0;
+    uint64_t bytes = 0;
+    uint64_t lost = 0; // Dropped for LinkConditions::loss
+    uint64_t reordered = 0; // Held back for LinkConditions::reorder
+    uint64_t unreachable = 0; // Sent to a port nothing is bound to
+};
+
+/**
+ * A network in memory between peers in one process, so a host and its clients can be run and measured together without
+ * sockets, under whatever latency, jitter, loss and reordering the test calls for. Every peer is at 127.0.0.1, told
+ * apart by the port their LoopbackTransport is bound to.
+ *
+ * The random choices come from a generator seeded at construction, so a single threaded run is repeatable. Safe to use
+ * from several threads.
+ */
+class LoopbackNetwork {
+public:
+    explicit LoopbackNetwork(uint32_t seed = 1);
+
+    void SetConditions(LinkConditions const& conditions);
+    LoopbackStats Stats();
+
+private:
+    friend class LoopbackTransport;
+
+    struct InFlight {
+        std::chrono::steady_clock::time_point deliverAt;
+        uint64_t order; // Sent before any with a higher one, for datagrams due at the same time
+        unsigned short senderPort;
+        std::vector<char> data;
+    };
+
+    std::mutex mutex; // Guards everything here, and every bound transport's queue
+    LinkConditions conditions;
+    LoopbackStats stats;
+    std::mt19937 random;
+    uint64_t sent;
+    std::unordered_map<unsigned short, LoopbackTransport*> ports;
+    unsigned short nextEphemeralPort;
+
+    bool Bind(LoopbackTransport* transport, unsigned short& port);
+    void Unbind(unsigned short port);
+    void Send(unsigned short senderPort, void const* data, std::size_t size, unsigned short port);
+};
+
+/**
+ * A peer's end of a LoopbackNetwork. Never blocks: datagrams still in flight simply aren't received yet.
+ */
+class LoopbackTransport : public Transport {
+public:
+    explicit LoopbackTransport(LoopbackNetwork& network);
+    ~LoopbackTransport() override;
+    LoopbackTransport(LoopbackTransport const&) = delete;
+    LoopbackTransport& operator=(LoopbackTransport const&) = delete;
+
+    bool Bind(unsigned short port) override;
+    void SetBlocking(bool /*blocking*/) override {} // Never blocks
+    unsigned short LocalPort() const {return port;}
+
+    sf::Socket::Status Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) override;
+    std::size_t ReceiveBatch(std::vector<ReceivedDatagram>& datagrams) override;
+    std::size_t SendToAll(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) override;
+
+private:
+    friend class LoopbackNetwork;
+
+    LoopbackNetwork& network;
+    unsigned short port; // 0 until bound
+    std::vector<LoopbackNetwork::InFlight> inFlight; // A heap, the next due at the front
+};
+
+#endif //GAMEBOYEMULATOR_LOOPBACKTRANSPORT_HPP
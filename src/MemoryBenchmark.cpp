@@ -0,0 +1,70 @@
+//
+// Created by Austin on 10/19/2026.
+//
+// Times the MMU's WRAM reads and writes, with and without entries in its write-ignore and OR-mask tables, to check the
+// hooks stay cheap on the hot path:
+//
+//   MemoryBenchmark [-accesses=N]
+//
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "GameBoy.hpp"
+
+/**
+ * Runs the access (reads or writes across WRAM) the given number of times and returns the average nanoseconds per
+ * access. The sum of everything read is kept in sink so the reads can't be optimized away.
+ */
+template <typename Access>
+double TimeAccesses(uint64_t accesses, Access access) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t index = 0; index < accesses; ++index) {
+        access(static_cast<uint16_t>(0xC000 + (index & 0x1FFF)));
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / accesses;
+}
+
+void PrintResult(std::string const& name, double nanoseconds) {
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << nanoseconds << " ns/access" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t accesses = 100000000;
+    for (int argument = 1; argument < argc; ++argument) {
+        auto arg = std::string(argv[argument]);
+        if (arg.find("-accesses=") == 0) {
+            accesses = std::stoull(arg.substr(10));
+        }
+    }
+
+    // No game is needed, WRAM reads and writes never reach the cartridge
+    GameBoy gameboy;
+    auto& mmu = gameboy.mmu;
+    uint64_t sink = 0;
+    auto read = [&](uint16_t address) {sink += mmu.ReadByte(address);};
+    auto write = [&](uint16_t address) {mmu.WriteByte(address, static_cast<uint8_t>(address));};
+
+    PrintResult("Read WRAM, no masks", TimeAccesses(accesses, read));
+    PrintResult("Write WRAM, nothing ignored", TimeAccesses(accesses, write));
+
+    // Worst case for reads, a mask in every page so every read takes the masked path
+    for (uint16_t address = 0xC000; address < 0xE000; address += 0x100) {
+        mmu.orBitMask.Set(address, 0x01);
+    }
+    mmu.orBitMask.Set(0xC10C, 0x0F); // Where the simulated players' collisions go
+    PrintResult("Read WRAM, a mask in every page", TimeAccesses(accesses, read));
+
+    // Every 64th address ignored, plus the one the battle hooks ignore
+    for (uint16_t address = 0xC000; address < 0xE000; address += 0x40) {
+        mmu.ignoreMemoryWrites.Insert(address);
+    }
+    mmu.ignoreMemoryWrites.Insert(0xccdd);
+    PrintResult("Write WRAM, every 64th ignored", TimeAccesses(accesses, write));
+
+    // Printed so the reads have a use, the value itself means nothing
+    std::cout << "(" << sink << ")" << std::endl;
+    return 0;
+}
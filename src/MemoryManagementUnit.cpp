@@ -17,61 +17,86 @@
 #include "Gameboy.hpp"
 #include "Network.hpp"
 
+namespace {
+    /**
+     * Marks the offsets in the enemy's party data that the battle itself changes (PP, HP, experience, stats and the
+     * like), whose writes mustn't reach the override the other player sent. The offsets are from the start of the party
+     * data rather than of each party_struct, as they always have been.
+     */
+    struct PartyMask {
+        uint8_t offsets[0x194];
+    };
+
+    constexpr PartyMask MakeBattleChangesMask() {
+        PartyMask mask{};
+        uint8_t const changed[] = {0x00, 0x03, 0x05, 0x06, 0x0E, 0x0F, 0x10, 0x1B, 0x1C, 0x21, 0x22, 0x23};
+        for (unsigned int index = 0; index < 6; ++index) {
+            for (auto offset : changed) {
+                mask.offsets[offset + index * 0x2C] = 1;
+            }
+        }
+        return mask;
+    }
+
+    constexpr PartyMask kBattleChangesMask = MakeBattleChangesMask();
+}
+
 /**
  * Initialize memory
  */
 MemoryManagementUnit::MemoryManagementUnit() {
-    rom = std::vector<uint8_t>(0x10000, 0);
-    cartridge_rom = std::vector<uint8_t>(0x200000, 0);
+    cartridge_rom = RomImage::Empty();
+    rom_banks = cartridge_rom->Banks();
     vram = std::vector<uint8_t>(0x2000, 0);
     eram = std::vector<uint8_t>(0x20000, 0); // MBC5 allows up to 128KB of external RAM
     wram = std::vector<uint8_t>(0x2000, 0);
     oam = std::vector<uint8_t>(0x100, 0);
     zram = std::vector<uint8_t>(0x100, 0);
     hram = std::vector<uint8_t>(0x100, 0);
+    
+    overlays[PLAYER_PARTY] = {0xd163, 0x110, wPartyMons.data(), nullptr, false, false};
+    overlays[ENEMY_PARTY] = {0xd89c, 0x153, wEnemyMons.data(), kBattleChangesMask.offsets, false, false};
 
     Reset();
     
     save_name = "";
+    recordSerial = false;
 }
 
 /**
- * Loads cartridge rom into rom array
+ * Maps the cartridge rom, sharing the mapping with any other instance that already loaded it
  */
 void MemoryManagementUnit::LoadRom(std::string rom_name) {
     // Load Gameboy ROM
     std::string rom_location = "../../rom/" + rom_name;
-    std::ifstream input(rom_location, std::ios::in | std::ios::binary);
-    char byte;
-    std::size_t index = 0;
-    while(input.get(byte)) {
-        cartridge_rom[index++] = static_cast<uint8_t>(byte);
-    }
-
-    // Copy over relevant cartridge memory to rom read-only section
-    for (index = 0; index < 0x8000; ++index) {
-        rom[index] = cartridge_rom[index];
+    cartridge_rom = RomImage::Open(rom_location);
+    if (!cartridge_rom) {
+        std::cout << "Failed to load rom: " << rom_location << std::endl;
+        cartridge_rom = RomImage::Empty();
     }
+    rom_banks = cartridge_rom->Banks();
 
     Reset();
 }
 
-void MemoryManagementUnit::Initialize(Processor* cpu_, Input* input_, Display* display_, Timer* timer_, Network* network_) {
+void MemoryManagementUnit::Initialize(Processor* cpu_, Input* input_, Display* display_, Timer* timer_, Network* network_,
+                                      PerformanceCounters* counters_) {
     cpu = cpu_;
     input = input_;
 	display = display_;
 	timer = timer_;
     network = network_;
+    counters = counters_;
 }
 
 void MemoryManagementUnit::Reset() {
-    overridePokemonParty = false;
-    overrideEnemyParty = false;
-    ignoreEnemyBattleChanges = false;
+    SetOverlayActive(PLAYER_PARTY, false);
+    SetOverlayActive(ENEMY_PARTY, false);
     reachedSelectEnemyMove = false;
     changePokemon = false;
     setLinkState = false;
     reachedInitBattle = false;
+    serialOutput.clear();
     
     bios_mode = false;//true;
     bios = {0x31, 0xFE, 0xFF, 0xAF, 0x21, 0xFF, 0x9F, 0x32, 0xCB, 0x7C, 0x20, 0xFB, 0x21, 0x26, 0xFF, 0x0E, // 16/row (0-15)
@@ -127,9 +152,10 @@ void MemoryManagementUnit::Reset() {
     hram[0xFFFF&0xFF] = 0x00; interrupt_enable = 0x00; // the two are equivalent
 	interrupt_flag = 0xE1; // 0xFF0F
 
+	const uint8_t* header = rom_banks[0];
 	game_title = "";
-	for (uint16_t address = 0x0134; address <= 0x0143 and cartridge_rom[address] != 0; ++address) {
-		game_title.push_back(cartridge_rom[address]);
+	for (uint16_t address = 0x0134; address <= 0x0143 and header[address] != 0; ++address) {
+		game_title.push_back(header[address]);
 	}
 	
     // Setup ROM banks and RAM
@@ -139,7 +165,7 @@ void MemoryManagementUnit::Reset() {
     updateSaveFile = false;
 
     // Setup configuration of controller type
-    cartridge_type = cartridge_rom[0x0147];
+    cartridge_type = header[0x0147];
     switch (cartridge_type) {
         case 0x00:
             // ROM only (no bank switching)
@@ -275,7 +301,7 @@ void MemoryManagementUnit::Reset() {
     }
 
     // Number of 16KB (0x4000) banks available
-    switch (cartridge_rom[0x0148]) {
+    switch (header[0x0148]) {
         case 0:
         case 1:
         case 2:
@@ -285,7 +311,7 @@ void MemoryManagementUnit::Reset() {
         case 6:
         case 7:
         case 8:
-            mbc.number_rom_banks = std::pow(2, cartridge_rom[0x0148]+1);
+            mbc.number_rom_banks = std::pow(2, header[0x0148]+1);
             break;
 
         case 0x52:
@@ -313,7 +339,7 @@ void MemoryManagementUnit::Reset() {
     }
 
     mbc.rom_offset = 0x4000;
-    ram_size = cartridge_rom[0x0149]; // RAM type available
+    ram_size = header[0x0149]; // RAM type available
 
     mbc.rom_bank = 1;
     mbc.ram_bank = 0;
@@ -325,6 +351,8 @@ void MemoryManagementUnit::Reset() {
  * Returns byte read from provided address
  */
 uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
+    counters->CountRead(address);
+    
     if (network->inBattle and address == 0x6f12 and mbc.rom_offset / 0x4000 == 0xF) {
         reachedInitBattle = true;
     }
@@ -345,11 +373,13 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
     }
     if (network->inBattle and address == 0xd12b and setLinkState) {
         // When reading wLinkState, return true if enabled for next wLinkState read
+        ++counters->hookHits;
         setLinkState = false;
         return static_cast<uint8_t>(0x04);
     }
     
     if (network->inBattle and address == 0xffaa) {
+        ++counters->hookHits;
         // This determines the difference between the battle "host" and "client" for things like equal speed who goes first
         if (isBattleInitiator) {
             return static_cast<uint8_t>(0x02);
@@ -359,10 +389,12 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
     }
     
     if (network->inBattle and address == 0xccd5) {
+        ++counters->hookHits;
         return static_cast<uint8_t>(0x00);
     }
     
     if (network->inBattle and address == 0x6e9b and mbc.rom_offset / 0x4000 == 0xF) {
+        ++counters->hookHits;
         // If BattleRandom is called, load a with random value and force a "RET" instruction
         seed = RandomFunction(seed);
         cpu->AF.higher = static_cast<uint8_t>(seed % 255);
@@ -370,6 +402,7 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
     }
     
     if (network->inBattle and changePokemon and address == 0x42a9 and mbc.rom_offset / 0x4000 == 0xF) {
+        ++counters->hookHits;
         // Program Counter is at SelectEnemyMove but we want the enemy to change pokemon, so change
         // the program counter to the location to switch pokemon for enemy
         cpu->program_counter.word = 0x42b0;
@@ -377,13 +410,13 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
         WriteByte(0xcf92, static_cast<uint8_t>(whichPokemon)); // whichPokemon
         WriteByte(0xcd6a, static_cast<uint8_t>(action)); // wActionResultOrTookBattleTurn
         WriteByte(0xccdd, 0xff); // wEnemySelectedMove = cannot select move
-        ignoreMemoryWrites.insert(0xccdd);
+        ignoreMemoryWrites.Insert(0xccdd);
         changePokemon = false;
     }
     
     if (network->inBattle and address == 0x5564 and mbc.rom_offset / 0x4000 == 0xF) {
         // Enemy move is done, remove any possible override for wEnemySelectedMove
-        ignoreMemoryWrites.erase(0xccdd);
+        ignoreMemoryWrites.Erase(0xccdd);
     }
      
     if (network->inBattle and address == 0x5564 and mbc.rom_offset / 0x4000 == 0xF) {
@@ -391,17 +424,17 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
         reachedSelectEnemyMove = true;
     }
     
-    if (network->inBattle and address == 0xccdd and overrideEnemyMove and ignoreMemoryWrites.count(0xccdd) == 0) {
+    if (network->inBattle and address == 0xccdd and overrideEnemyMove and !ignoreMemoryWrites.Contains(0xccdd)) {
+        ++counters->hookHits;
         // wSelectedEnemyMove being read, override enemy move
         return enemyMove;
     }
     
-    if (network->inBattle and overridePokemonParty and address >= 0xd163 and address < 0xd273) {
-        // If overriding pokemon party, use the pre-defined memory block
-        return wPartyMons[address - 0xd163];
-    }
-    if (network->inBattle and overrideEnemyParty and address >= 0xd89c and address <= 0xd9ee) {
-        return wEnemyMons[address - 0xd89c];
+    if (network->inBattle and overlaidAddresses.Contains(address)) {
+        ++counters->hookHits;
+        // If overriding a pokemon party, use the pre-defined memory block
+        auto overlay = FindOverlay(address);
+        return overlay->data[address - overlay->start];
     }
     
     switch(address & 0xF000) {
@@ -411,7 +444,7 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
         case 0x2000:
         case 0x3000:
             // ROM Bank 0 read
-            return cartridge_rom[address];
+            return rom_banks[0][address];
 
         // Rom banks 1 and higher
         case 0x4000:
@@ -420,9 +453,9 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
         case 0x7000:
               if (address == 0x5719 and mbc.rom_offset / 0x4000 == 0xE) {
                 // If the AI is deciding a move, this means the battle has started
-                ignoreEnemyBattleChanges = false;
+                overlays[ENEMY_PARTY].captureWrites = true;
             }
-			return cartridge_rom[static_cast<unsigned int>(address&0x3FFF) + mbc.rom_offset];
+			return rom_banks[(mbc.rom_offset / 0x4000) & (RomImage::kMaxBanks - 1)][address & 0x3FFF];
 
         // VRAM
         case 0x8000:
@@ -486,8 +519,8 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
         case 0xC000:
         case 0xD000:
         case 0xE000:
-            if (orBitMask.count(address)) {
-                return (wram[address & 0x1FFF] | orBitMask[address]);
+            if (orBitMask.Contains(address)) {
+                return (wram[address & 0x1FFF] | orBitMask.Mask(address));
             }
             return wram[address & 0x1FFF];
 
@@ -564,6 +597,20 @@ uint8_t MemoryManagementUnit::ReadByte(uint16_t address) {
 /**
  * Reads and returns 2 bytes at address (lower) and address+1 (upper byte)
  */
+/**
+ * Returns true while in a remote battle, when ReadByte watches for (and overrides) reads of ROM code.
+ */
+bool MemoryManagementUnit::BattleHooksActive() const {
+    return network->inBattle;
+}
+
+/**
+ * Returns true if ReadByte does more than read the ROM address even outside of battle, so it mustn't be skipped.
+ */
+bool MemoryManagementUnit::RomReadHasSideEffects(uint16_t address, unsigned int bank) const {
+    return address == 0x5719 and bank == 0xE;
+}
+
 uint16_t MemoryManagementUnit::ReadWord(uint16_t address) {
 	return static_cast<uint16_t>(ReadByte(address)) + (static_cast<uint16_t>(ReadByte(address + 1)) << 8);
 }
@@ -572,10 +619,17 @@ uint16_t MemoryManagementUnit::ReadWord(uint16_t address) {
  * Writes a single byte to memory.
  */
 void MemoryManagementUnit::WriteByte(uint16_t address, uint8_t value) {
-    if (ignoreMemoryWrites.count(address)) return;
+    counters->CountWrite(address);
+    if (ignoreMemoryWrites.Contains(address)) return;
     
-    if (network->inBattle and overrideEnemyParty and !ignoreEnemyBattleChanges and !IsNotBattleChanges(address) and address >= 0xd89c and address <= 0xd9ee) {
-        wEnemyMons[address - 0xd89c] = value;
+    if (network->inBattle and overlaidAddresses.Contains(address)) {
+        // Once the battle starts, its changes to an overridden party are kept in the override
+        auto overlay = FindOverlay(address);
+        uint16_t offset = address - overlay->start;
+        if (overlay->captureWrites and !(overlay->writeFilter and overlay->writeFilter[offset])) {
+            ++counters->hookHits;
+            overlay->data[offset] = value;
+        }
     }
     
     switch(address & 0xF000) {
@@ -751,8 +805,9 @@ void MemoryManagementUnit::WriteByte(uint16_t address, uint8_t value) {
                                         break;
 
                                     case 2:
-                                        if (value & 0x80) {
-                                            //std::cout << "SERIAL: " << zram[0x01] << std::endl;;
+                                        if ((value & 0x80) and recordSerial) {
+                                            // Transfer started, there is no link partner so just keep what was sent
+                                            serialOutput.push_back(static_cast<char>(zram[0x01]));
                                         }
                                         break;
 
@@ -806,6 +861,7 @@ void MemoryManagementUnit::WriteWord(uint16_t address, uint16_t value) {
  * Transfers from origin->origin+9F to FE00->FE9F.
  */
 void MemoryManagementUnit::TransferToOAM(uint16_t origin) {
+    ++counters->oamDmas;
     for (uint16_t offset = 0; offset < 0xA0; ++offset) {
         uint8_t value = ReadByte(origin+offset);
         oam[offset] = value;
@@ -818,12 +874,11 @@ void MemoryManagementUnit::TransferToOAM(uint16_t origin) {
  */
 void MemoryManagementUnit::SetPartyMonsters(const std::vector<Pokemon>& party, const std::array<uint8_t, 8>& partyData, bool enemy) {
     if (!enemy) {
-        overridePokemonParty = true;
         PopulateParty(party, partyData, wPartyMons);
+        SetOverlayActive(PLAYER_PARTY, true);
     } else {
-        overrideEnemyParty = true;
-        ignoreEnemyBattleChanges = true;
         PopulateParty(party, partyData, wEnemyMons);
+        SetOverlayActive(ENEMY_PARTY, true);
     }
 }
 
@@ -832,12 +887,11 @@ void MemoryManagementUnit::SetPartyMonsters(const std::vector<Pokemon>& party, c
  */
 void MemoryManagementUnit::SetPartyMonsters(const std::array<uint8_t, 0x194>& party, bool enemy) {
     if (!enemy) {
-        overridePokemonParty = true;
         wPartyMons = party;
+        SetOverlayActive(PLAYER_PARTY, true);
     } else {
-        overrideEnemyParty = true;
-        ignoreEnemyBattleChanges = true;
         wEnemyMons = party;
+        SetOverlayActive(ENEMY_PARTY, true);
     }
 }
 
@@ -845,14 +899,35 @@ void MemoryManagementUnit::SetPartyMonsters(const std::array<uint8_t, 0x194>& pa
  * Removes the override for the party. This should be called after the battle starts (before the first move is made).
  */
 void MemoryManagementUnit::ResetPartyMonsters(bool enemy) {
-    if (!enemy) {
-        overridePokemonParty = false;
-    } else {
-        overrideEnemyParty = false;
-        ignoreEnemyBattleChanges = false;
+    SetOverlayActive(!enemy ? PLAYER_PARTY : ENEMY_PARTY, false);
+}
+
+/**
+ * Starts or stops redirecting the overlay's range. Writes aren't captured until the battle starts (see ReadByte).
+ */
+void MemoryManagementUnit::SetOverlayActive(Overlay overlay, bool active) {
+    auto& range = overlays[overlay];
+    range.active = active;
+    range.captureWrites = false;
+    for (unsigned int offset = 0; offset < range.length; ++offset) {
+        if (active) {
+            overlaidAddresses.Insert(static_cast<uint16_t>(range.start + offset));
+        } else {
+            overlaidAddresses.Erase(static_cast<uint16_t>(range.start + offset));
+        }
     }
 }
 
+/**
+ * Returns the active overlay covering the address, which must be in overlaidAddresses.
+ */
+MemoryOverlay* MemoryManagementUnit::FindOverlay(uint16_t address) {
+    for (auto& overlay : overlays) {
+        if (overlay.Covers(address)) return &overlay;
+    }
+    return nullptr;
+}
+
 /**
  * Populates the provided pokemon party array.
  */
@@ -926,33 +1001,6 @@ std::array<uint8_t, 0x194> MemoryManagementUnit::SavePartyMonstersFromMemory(boo
     return party;
 }
 
-/**
- * Returns true if the address is not the enemy's battle stats such as PP, HP, speed, etc.
- */
-bool MemoryManagementUnit::IsNotBattleChanges(uint16_t address) {
-    uint16_t offset = 0xd89c;
-    
-    for (unsigned int index = 0; index < 6; ++index) {
-        if (address == offset + 0x00 + index * 0x2C ||
-            address == offset + 0x03 + index * 0x2C ||
-            address == offset + 0x05 + index * 0x2C ||
-            address == offset + 0x06 + index * 0x2C ||
-            address == offset + 0x0E + index * 0x2C ||
-            address == offset + 0x0F + index * 0x2C ||
-            address == offset + 0x10 + index * 0x2C ||
-            address == offset + 0x1B + index * 0x2C ||
-            address == offset + 0x1C + index * 0x2C ||
-            address == offset + 0x21 + index * 0x2C ||
-            address == offset + 0x22 + index * 0x2C ||
-            address == offset + 0x23 + index * 0x2C) {
-            return true;
-            // address - offset % 0x2C
-        } 
-    }
-    
-    return false;
-}
-
 /**
  * Produces a pseudo-random values.
  */
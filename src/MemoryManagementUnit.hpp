@@ -9,8 +9,11 @@
 #include <vector>
 #include <array>
 #include <string>
-#include <set>
-#include <unordered_map>
+#include <memory>
+
+#include "AddressTables.hpp"
+#include "RomImage.hpp"
+#include "PerformanceCounters.hpp"
 
 struct MemoryBankController {
     unsigned int rom_bank = 1; // Current bank selected
@@ -63,8 +66,7 @@ class Pokemon;
 class MemoryManagementUnit {
 public:
     std::array<uint8_t, 0x0100> bios;
-    std::vector<uint8_t> rom;
-    std::vector<uint8_t> cartridge_rom;
+    std::shared_ptr<const RomImage> cartridge_rom; // Read-only and shared with any other instance running the same game
     std::vector<uint8_t> vram; // Graphics Memory
     std::vector<uint8_t> eram; // External RAM
     std::vector<uint8_t> wram; // Working RAM (internal 8K RAM to Gameboy)
@@ -82,10 +84,14 @@ public:
 	
 	std::string game_title;
     std::string save_name;
+    
+    bool recordSerial; // When set, every byte sent over the serial port is appended to serialOutput
+    std::string serialOutput;
 
     MemoryManagementUnit();
 
-    void Initialize(Processor* cpu_, Input* input_, Display* display_, Timer* timer_, Network* network_);
+    void Initialize(Processor* cpu_, Input* input_, Display* display_, Timer* timer_, Network* network_,
+                    PerformanceCounters* counters_);
     void Reset();
     void LoadRom(std::string rom_name);
     void LoadSave(std::string save_filename);
@@ -96,9 +102,15 @@ public:
     void WriteByte(uint16_t address, uint8_t value);
     void WriteWord(uint16_t address, uint16_t value);
     
-    // Anything that has a key is ignored for writes
-    std::set<uint16_t> ignoreMemoryWrites;
-    std::unordered_map<uint16_t, uint8_t> orBitMask; // Bitwise OR for WRAM address with provided value
+    // For running code from ROM without reading it through ReadByte
+    unsigned int CurrentRomBank() const {return (mbc.rom_offset / 0x4000) & (RomImage::kMaxBanks - 1);}
+    const uint8_t* RomBank(unsigned int bank) const {return rom_banks[bank];}
+    bool BattleHooksActive() const;
+    bool RomReadHasSideEffects(uint16_t address, unsigned int bank) const;
+    
+    // Checked on every write and WRAM read, so both are flat tables rather than lookups
+    AddressSet ignoreMemoryWrites; // Writes to these addresses are dropped
+    WramOrMask orBitMask; // Bitwise OR for WRAM address with provided value
     
     void SetPartyMonsters(const std::vector<Pokemon>& party, const std::array<uint8_t, 8>& partyData, bool enemy); // Overrides party monsters
     void SetPartyMonsters(const std::array<uint8_t, 0x194>& party, bool enemy);
@@ -124,18 +136,29 @@ private:
 	Display* display;
 	Timer* timer;
     Network* network;
+    PerformanceCounters* counters;
     
     // Ignore list: 0x55d2 (chooseRandomMove), 
     // Approve list: 0x669c (RandomizeDamage), 0x6602 (doAccuracyCheck), 0x756a (StatModifierDownEffect), 0x607d (CriticalHitTest)
     std::array<uint16_t, 4> const battleRandomAddresses = {{0x669c, 0x6602, 0x756a, 0x607d}};
+    
+    const uint8_t* const* rom_banks; // cartridge_rom's bank table, indexed by mbc.rom_offset / 0x4000
 
     void TransferToOAM(uint16_t origin);
     void PopulateParty(const std::vector<Pokemon>& party, const std::array<uint8_t, 8>& partyData, std::array<uint8_t, 0x194>& partyArray);
-    bool IsNotBattleChanges(uint16_t address);
     
-    bool overridePokemonParty;
-    bool overrideEnemyParty;
-    bool ignoreEnemyBattleChanges;
+    // Ranges of memory replaced while in a remote battle. Only addresses in overlaidAddresses need their overlay found,
+    // so adding more doesn't slow down other reads and writes.
+    enum Overlay {
+        PLAYER_PARTY,
+        ENEMY_PARTY,
+        OVERLAY_COUNT
+    };
+    std::array<MemoryOverlay, OVERLAY_COUNT> overlays;
+    AddressSet overlaidAddresses; // Every address covered by an active overlay
+    void SetOverlayActive(Overlay overlay, bool active);
+    MemoryOverlay* FindOverlay(uint16_t address);
+    
     std::array<uint8_t, 0x194> wPartyMons;
     std::array<uint8_t, 0x194> wEnemyMons;
 };
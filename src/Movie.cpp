@@ -0,0 +1,286 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "Movie.hpp"
+#include "Processor.hpp"
+#include "MemoryManagementUnit.hpp"
+#include "Display.hpp"
+#include "Input.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Movie file format (little endian):
+//   "PSMV", version (1 byte), game title length (1 byte) and title, flags (1 byte, bit 0 = starts from snapshot),
+//   start clock (8 bytes), frames (8 bytes),
+//   input count (4 bytes), then per input: clock since the previous input (varint) and joypad state (1 byte),
+//   hash count (4 bytes), then each frame hash (8 bytes)
+namespace {
+    char const kMagic[4] = {'P', 'S', 'M', 'V'};
+    uint8_t const kVersion = 1;
+
+    void WriteInteger(std::ostream& output, uint64_t value, int bytes) {
+        for (int index = 0; index < bytes; ++index) {
+            output.put(static_cast<char>((value >> (index*8)) & 0xFF));
+        }
+    }
+
+    uint64_t ReadInteger(std::istream& input, int bytes) {
+        uint64_t value = 0;
+        for (int index = 0; index < bytes; ++index) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(input.get())) << (index*8);
+        }
+        return value;
+    }
+
+    // Most inputs are a few thousand clocks apart, so this keeps them to two or three bytes each
+    void WriteVarint(std::ostream& output, uint64_t value) {
+        while (value >= 0x80) {
+            output.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        output.put(static_cast<char>(value));
+    }
+
+    uint64_t ReadVarint(std::istream& input) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64 and input; shift += 7) {
+            auto byte = static_cast<uint8_t>(input.get());
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        return value;
+    }
+
+    /**
+     * How many bytes are left to read, so counts read from a file can be checked against what could possibly follow.
+     */
+    uint64_t BytesLeft(std::istream& input) {
+        auto position = input.tellg();
+        input.seekg(0, std::ios::end);
+        auto end = input.tellg();
+        input.seekg(position);
+        return position >= 0 and end > position ? static_cast<uint64_t>(end - position) : 0;
+    }
+}
+
+Movie::Movie()
+    : recording(false)
+    , replaying(false)
+    , startsFromSnapshot(false)
+    , startClock(0)
+    , frames(0)
+    , currentFrame(0)
+    , lastJoypadState(0xFF)
+    , nextInput(0)
+    , hashesChecked(0)
+    , firstMismatchedFrame(-1) {
+}
+
+Movie::~Movie() {
+    StopRecording();
+}
+
+void Movie::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Display* display_, Input* input_) {
+    cpu = cpu_;
+    mmu = mmu_;
+    display = display_;
+    input = input_;
+}
+
+/**
+ * Starts recording from the current state, first saving it as a snapshot if requested. The movie is written when
+ * recording stops.
+ */
+bool Movie::StartRecording(std::string const& file_name, bool snapshot) {
+    if (recording or replaying) return false;
+
+    fileName = file_name;
+    startsFromSnapshot = snapshot;
+    if (snapshot) {
+        input->SaveGameState(file_name + ".gbs");
+    }
+
+    startClock = cpu->clock;
+    frames = 0;
+    currentFrame = 0;
+    frameHashes.clear();
+    inputs.clear();
+
+    // The joypad may not start out released (a key held while the snapshot was taken)
+    lastJoypadState = input->JoypadState();
+    inputs.push_back({cpu->clock, lastJoypadState});
+
+    std::cout << "Recording movie: " << fileName << std::endl;
+    recording = true;
+    return true;
+}
+
+/**
+ * Stops recording and writes the movie. Returns false if not recording or the movie couldn't be written.
+ */
+bool Movie::StopRecording() {
+    if (!recording) return false;
+    recording = false;
+    frames = currentFrame;
+
+    if (!Write()) {
+        std::cout << "Failed to write movie: " << fileName << std::endl;
+        return false;
+    }
+    std::cout << "Wrote movie: " << fileName << " (" << frames << " frames, " << inputs.size() << " inputs)" << std::endl;
+    return true;
+}
+
+/**
+ * Starts replaying the movie, loading its snapshot if it has one. The movie's game must already be loaded.
+ */
+bool Movie::StartReplay(std::string const& file_name) {
+    if (recording or replaying) return false;
+
+    fileName = file_name;
+    std::string game_title;
+    if (!Read(game_title)) {
+        std::cout << "Failed to read movie: " << fileName << std::endl;
+        return false;
+    }
+    if (game_title != mmu->game_title) {
+        std::cout << "Movie " << fileName << " was recorded with " << game_title << ", not " << mmu->game_title
+                  << std::endl;
+        return false;
+    }
+
+    if (startsFromSnapshot) {
+        if (!std::ifstream(fileName + ".gbs")) {
+            std::cout << "Missing movie snapshot: " << fileName << ".gbs" << std::endl;
+            return false;
+        }
+        input->LoadGameState(fileName + ".gbs");
+    }
+    if (cpu->clock != startClock) {
+        std::cout << "Movie starts at clock " << startClock << " but the game is at " << cpu->clock
+                  << ", replay will not match" << std::endl;
+    }
+
+    currentFrame = 0;
+    hashesChecked = 0;
+    firstMismatchedFrame = -1;
+    input->SetJoypadState(inputs[0].joypadState);
+    nextInput = 1;
+    replaying = true;
+    return true;
+}
+
+/**
+ * Records the joypad if it changed since it was last recorded. Called on every joypad read.
+ */
+void Movie::RecordInput() {
+    auto joypadState = input->JoypadState();
+    if (joypadState != lastJoypadState) {
+        inputs.push_back({cpu->clock, joypadState});
+        lastJoypadState = joypadState;
+    }
+}
+
+/**
+ * Applies every recorded change up to the current clock. Called on every joypad read in place of the keyboard.
+ */
+void Movie::ReplayInput() {
+    while (nextInput < inputs.size() and inputs[nextInput].clock <= cpu->clock) {
+        auto joypadState = inputs[nextInput++].joypadState;
+        if (input->JoypadState() & ~joypadState) {
+            mmu->interrupt_flag |= 0x04; // A key was pressed, same as Input::KeyDown
+        }
+        input->SetJoypadState(joypadState);
+    }
+}
+
+/**
+ * Counts the frame, recording or checking its hash every kHashInterval frames. Replays stop after the last frame.
+ */
+void Movie::EndFrame() {
+    if (!recording and !replaying) return;
+
+    ++currentFrame;
+    if (currentFrame % kHashInterval == 0) {
+        auto hash = display->FrameHash();
+        if (recording) {
+            frameHashes.push_back(hash);
+        } else {
+            std::size_t index = currentFrame / kHashInterval - 1;
+            if (index < frameHashes.size()) {
+                ++hashesChecked;
+                if (hash != frameHashes[index] and firstMismatchedFrame < 0) {
+                    firstMismatchedFrame = static_cast<int64_t>(currentFrame);
+                }
+            }
+        }
+    }
+
+    if (replaying and currentFrame >= frames) {
+        replaying = false;
+    }
+}
+
+bool Movie::Write() const {
+    std::ofstream output(fileName, std::ios::out | std::ios::binary);
+    if (!output) return false;
+
+    output.write(kMagic, sizeof(kMagic));
+    WriteInteger(output, kVersion, 1);
+    std::string title = mmu->game_title.substr(0, 0xFF);
+    WriteInteger(output, title.size(), 1);
+    output.write(title.data(), title.size());
+    WriteInteger(output, startsFromSnapshot ? 1 : 0, 1);
+    WriteInteger(output, startClock, 8);
+    WriteInteger(output, frames, 8);
+
+    WriteInteger(output, inputs.size(), 4);
+    uint64_t previousClock = startClock;
+    for (auto const& movieInput : inputs) {
+        WriteVarint(output, movieInput.clock - previousClock);
+        WriteInteger(output, movieInput.joypadState, 1);
+        previousClock = movieInput.clock;
+    }
+
+    WriteInteger(output, frameHashes.size(), 4);
+    for (auto hash : frameHashes) {
+        WriteInteger(output, hash, 8);
+    }
+    return static_cast<bool>(output);
+}
+
+bool Movie::Read(std::string& game_title) {
+    std::ifstream file(fileName, std::ios::in | std::ios::binary);
+    char magic[sizeof(kMagic)];
+    if (!file.read(magic, sizeof(magic)) or !std::equal(magic, magic + sizeof(magic), kMagic)) return false;
+    if (ReadInteger(file, 1) != kVersion) return false;
+
+    game_title.resize(ReadInteger(file, 1));
+    file.read(&game_title[0], game_title.size());
+    startsFromSnapshot = ReadInteger(file, 1) & 0x01;
+    startClock = ReadInteger(file, 8);
+    frames = ReadInteger(file, 8);
+    if (!file) return false;
+
+    // Each input takes at least 2 bytes and each hash 8, so a corrupt count is rejected before anything is allocated
+    auto inputCount = ReadInteger(file, 4);
+    if (!file or inputCount > BytesLeft(file) / 2) return false;
+    inputs.resize(inputCount);
+    uint64_t clock = startClock;
+    for (auto& movieInput : inputs) {
+        clock += ReadVarint(file);
+        movieInput.clock = clock;
+        movieInput.joypadState = static_cast<uint8_t>(ReadInteger(file, 1));
+    }
+
+    auto hashCount = ReadInteger(file, 4);
+    if (!file or hashCount > BytesLeft(file) / 8) return false;
+    frameHashes.resize(hashCount);
+    for (auto& hash : frameHashes) {
+        hash = ReadInteger(file, 8);
+    }
+    return static_cast<bool>(file) and !inputs.empty();
+}
@@ -0,0 +1,86 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_MOVIE_HPP
+#define GAMEBOYEMULATOR_MOVIE_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class Processor;
+class MemoryManagementUnit;
+class Display;
+class Input;
+
+/**
+ * A change of joypad state and the clock of the joypad read that saw it.
+ */
+struct MovieInput {
+    uint64_t clock;
+    uint8_t joypadState; // See Input::JoypadState
+};
+
+/**
+ * Records joypad input to a movie file and replays it exactly.
+ *
+ * Only changes to the joypad are recorded, timestamped with the clock of the joypad read (0xFF00) that saw them.
+ * Emulation is deterministic, so on replay the same reads happen at the same clocks and each change is applied at the
+ * same instruction it originally was. Every kHashInterval frames the frame's hash is also stored, so a replay can check
+ * it drew exactly what the recording did.
+ *
+ * A movie either starts from power on (replay with the same -save, as the game may overwrite the .sav while recording)
+ * or from a snapshot saved next to it as MOVIE.gbs. Recordings should be made offline; other players change the game.
+ */
+class Movie {
+public:
+    static unsigned int const kHashInterval = 60;
+
+    Movie();
+    ~Movie();
+
+    void Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Display* display_, Input* input_);
+
+    bool StartRecording(std::string const& file_name, bool snapshot);
+    bool StopRecording();
+    bool StartReplay(std::string const& file_name);
+
+    void RecordInput();
+    void ReplayInput();
+    void EndFrame();
+
+    bool IsRecording() const {return recording;}
+    bool IsReplaying() const {return replaying;}
+
+    uint64_t Frames() const {return frames;} // Length of the movie
+    uint64_t CurrentFrame() const {return currentFrame;}
+    unsigned int HashesChecked() const {return hashesChecked;}
+    int64_t FirstMismatchedFrame() const {return firstMismatchedFrame;} // -1 if every checked frame matched
+
+private:
+    Processor* cpu;
+    MemoryManagementUnit* mmu;
+    Display* display;
+    Input* input;
+
+    bool recording;
+    bool replaying;
+    std::string fileName;
+    bool startsFromSnapshot;
+    uint64_t startClock;
+    uint64_t frames;
+    uint64_t currentFrame;
+    uint8_t lastJoypadState;
+
+    std::vector<MovieInput> inputs;
+    std::size_t nextInput;
+    std::vector<uint64_t> frameHashes; // Hash of every kHashInterval'th frame
+    unsigned int hashesChecked;
+    int64_t firstMismatchedFrame;
+
+    bool Write() const;
+    bool Read(std::string& game_title);
+};
+
+#endif //GAMEBOYEMULATOR_MOVIE_HPP
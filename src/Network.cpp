@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <iterator>
+
 #include "Network.hpp"
 #include "Input.hpp"
 #include "MemoryManagementUnit.hpp"
@@ -6,11 +9,39 @@
 #include "Timer.hpp"
 #include "Input.hpp"
 #include "GameBoy.hpp"
+#include "PerformanceCounters.hpp"
+#include "Profiler.hpp"
 
 void TestPacket(HostGameState hostGameState);
 
 // NOTE: Might want to make the connect logic TCP (gauranteed) and update gamestate logic UDP
 
+namespace {
+    std::size_t const kPartySize = std::tuple_size<Party>::value;
+    
+    // Connect requests are sent again after going this long unanswered, twice as long each time up to the most
+    std::chrono::milliseconds const kFirstConnectBackoff(250);
+    std::chrono::milliseconds const kMaxConnectBackoff(4000);
+    
+    void WriteHash(sf::Packet& packet, uint64_t hash) {
+        packet << static_cast<sf::Uint64>(hash);
+    }
+    
+    uint64_t ReadHash(sf::Packet& packet) {
+        sf::Uint64 hash = 0;
+        packet >> hash;
+        return hash;
+    }
+    
+    void WriteEcho(sf::Packet& packet, const LinkEcho& echo) {
+        packet << echo.sequence << echo.delay;
+    }
+    
+    void ReadEcho(sf::Packet& packet, LinkEcho& echo) {
+        packet >> echo.sequence >> echo.delay;
+    }
+}
+
 /**
  * Serializes a GenericRequestResponse.
  */
@@ -46,31 +77,48 @@ sf::Packet& operator >>(sf::Packet& packet, GenericRequestResponse& genericReque
 }
 
 /**
- * Serializes a NetworkGameState.
+ * Serializes a sprite straight from WRAM, in the same format as a SpriteState.
  */
-sf::Packet& operator <<(sf::Packet& packet, const NetworkGameState& networkGameState) {
-    packet << networkGameState.uniqueId << networkGameState.name << networkGameState.currentMap << networkGameState.walkBikeSurfState;
+sf::Packet& operator <<(sf::Packet& packet, const SpriteView& sprite) {
+    packet << sprite.SpriteIndex() << sprite.PictureId() << sprite.MoveStatus() << sprite.Direction()
+           << sprite.YDisplacement() << sprite.XDisplacement() << sprite.YPosition() << sprite.XPosition()
+           << sprite.CanMove() << sprite.InGrass();
+    return packet;
+}
+
+/**
+ * Deserializes a sprite.
+ */
+sf::Packet& operator >>(sf::Packet& packet, SpriteState& sprite) {
+    packet >> sprite.spriteIndex >> sprite.pictureId >> sprite.moveStatus >> sprite.direction
+           >> sprite.yDisplacement >> sprite.xDisplacement >> sprite.yPosition >> sprite.xPosition
+           >> sprite.canMove >> sprite.inGrass;
+    return packet;
+}
+
+/**
+ * Serializes the local game state straight from WRAM, in the format read as a NetworkGameState.
+ */
+void WriteGameState(sf::Packet& packet, int uniqueId, const std::string& name, const GameStateView& gameState, uint64_t partyHash,
+                    const PacketNumber& number, const LinkEcho& echo) {
+    packet << uniqueId << name << gameState.CurrentMap() << gameState.WalkBikeSurfState();
     
-    auto& playerPosition = networkGameState.playerPosition;
+    auto playerPosition = gameState.Position();
     packet << playerPosition.yPosition << playerPosition.xPosition 
            << playerPosition.yBlockPosition << playerPosition.xBlockPosition;
 
-    packet << static_cast<unsigned int>(networkGameState.sprites.size());
-    for (auto& sprite : networkGameState.sprites) {
-        packet << sprite.spriteIndex << sprite.pictureId << sprite.moveStatus << sprite.direction
-               << sprite.yDisplacement << sprite.xDisplacement << sprite.yPosition << sprite.xPosition
-               << sprite.canMove << sprite.inGrass;    
-    }
-    
-    for (unsigned int index = 0; index < 0x194; ++index) {
-        packet << networkGameState.partyMonsters[index];
+    packet << GameStateView::kSpriteCount;
+    for (unsigned int index = 0; index < GameStateView::kSpriteCount; ++index) {
+        packet << gameState.Sprite(index);
     }
     
-    return packet;
+    WriteHash(packet, partyHash);
+    packet << number.sequence << number.sentAt;
+    WriteEcho(packet, echo);
 }
 
 /**
- * Deserializes a NetworkGameState.
+ * Deserializes a NetworkGameState, leaving partyMonsters to be found by partyHash.
  */
 sf::Packet& operator >>(sf::Packet& packet, NetworkGameState& networkGameState) {
     packet >> networkGameState.uniqueId >> networkGameState.name >> networkGameState.currentMap >> networkGameState.walkBikeSurfState;
@@ -83,83 +131,192 @@ sf::Packet& operator >>(sf::Packet& packet, NetworkGameState& networkGameState)
     unsigned int spriteCount;
     packet >> spriteCount;
     networkGameState.sprites.resize(spriteCount);
-    for (unsigned int index = 0; index < spriteCount; ++index) {
-        auto& sprite = networkGameState.sprites[index];
-        packet >> sprite.spriteIndex >> sprite.pictureId >> sprite.moveStatus >> sprite.direction
-               >> sprite.yDisplacement >> sprite.xDisplacement >> sprite.yPosition >> sprite.xPosition
-               >> sprite.canMove >> sprite.inGrass;    
+    for (auto& sprite : networkGameState.sprites) {
+        packet >> sprite;
     }
     
-    for (unsigned int index = 0; index < 0x194; ++index) {
-        packet >> networkGameState.partyMonsters[index];
+    networkGameState.partyHash = ReadHash(packet);
+    networkGameState.partyResolved = false;
+    packet >> networkGameState.number.sequence >> networkGameState.number.sentAt;
+    ReadEcho(packet, networkGameState.echo);
+    return packet;
+}
+
+namespace {
+    /**
+     * How many bytes a player's entry in a HOST_PLAYERS message takes.
+     */
+    std::size_t PlayerEntrySize(const NetworkGameState& player) {
+        // uniqueId, name, map, walk/bike/surf, position, party hash and echo
+        return 4 + (4 + player.name.size()) + 4 + 4 + sizeof(PlayerPosition) + 8 + sizeof(LinkEcho);
     }
     
-    return packet;
+    /**
+     * Returns the next of messages to write, cleared, adding it if they're all in use.
+     */
+    sf::Packet& NextMessage(std::vector<sf::Packet>& messages, std::size_t& count) {
+        if (messages.size() <= count) messages.emplace_back();
+        auto& message = messages[count++];
+        message.clear();
+        return message;
+    }
 }
 
 /**
- * Serializes a HostGameState.
+ * Writes the players' game states (the host's first, if there is a host) and the host's sprites as messages of at most
+ * kMaxMessageSize bytes, into messages from the front (reusing their buffers), and returns how many it wrote.
+ *
+ * Players go as many to a HOST_PLAYERS message as fit, with the hashes of their parties rather than the parties, and
+ * the sprites (unless hostSprites is null) in one HOST_SPRITES message. A player with a name so long their entry can't
+ * fit with any other still gets a message of their own.
+ *
+ * Each message is numbered, the first with sequence + 1, and sequence is left as the last one's. Each player's entry
+ * carries their echo (the sender's echo of them, rather than theirs of the sender).
  */
-sf::Packet& operator <<(sf::Packet& packet, const HostGameState& hostGameState) {
-    packet << static_cast<unsigned int>(hostGameState.playerGameStates.size());
-    for (auto& playerGameState : hostGameState.playerGameStates) {
-        auto& playerPosition = playerGameState.playerPosition;
-        packet << playerGameState.uniqueId << playerGameState.name << playerGameState.currentMap << playerGameState.walkBikeSurfState
-               << playerPosition.yPosition << playerPosition.xPosition
-               << playerPosition.yBlockPosition << playerPosition.xBlockPosition;
-               
-        for (unsigned int index = 0; index < 0x194; ++index) {
-            packet << playerGameState.partyMonsters[index];
+std::size_t WriteHostGameStateMessages(std::vector<sf::Packet>& messages, std::vector<const NetworkGameState*> const& players,
+                                       const GameStateView* hostSprites, uint32_t& sequence) {
+    std::size_t count = 0;
+    auto playerCount = static_cast<unsigned int>(players.size());
+    auto sentAt = LinkClock();
+    
+    std::size_t const kPlayersHeaderSize = 24; // Type, number, player count, first player, entries
+    for (unsigned int first = 0; first < playerCount;) {
+        auto last = first + 1;
+        auto size = kPlayersHeaderSize + PlayerEntrySize(*players[first]);
+        while (last < playerCount and size + PlayerEntrySize(*players[last]) <= kMaxMessageSize) {
+            size += PlayerEntrySize(*players[last++]);
+        }
+        
+        auto& message = NextMessage(messages, count);
+        message << static_cast<int>(PacketType::HOST_PLAYERS) << ++sequence << sentAt << playerCount << first << last - first;
+        for (; first < last; ++first) {
+            auto& player = *players[first];
+            auto& playerPosition = player.playerPosition;
+            message << player.uniqueId << player.name << player.currentMap << player.walkBikeSurfState
+                    << playerPosition.yPosition << playerPosition.xPosition
+                    << playerPosition.yBlockPosition << playerPosition.xBlockPosition;
+            WriteHash(message, player.partyHash);
+            WriteEcho(message, player.echo);
         }
     }
-
-    packet << static_cast<unsigned int>(hostGameState.sprites.size());
-    for (auto& sprite : hostGameState.sprites) {
-        packet << sprite.spriteIndex << sprite.pictureId << sprite.moveStatus << sprite.direction
-               << sprite.yDisplacement << sprite.xDisplacement << sprite.yPosition << sprite.xPosition
-               << sprite.canMove << sprite.inGrass;    
+    
+    if (hostSprites and playerCount > 0) {
+        auto& message = NextMessage(messages, count);
+        message << static_cast<int>(PacketType::HOST_SPRITES) << ++sequence << sentAt
+                << players.front()->uniqueId << hostSprites->CurrentMap()
+                << GameStateView::kSpriteCount;
+        for (unsigned int index = 0; index < GameStateView::kSpriteCount; ++index) {
+            message << hostSprites->Sprite(index);
+        }
     }
     
-    return packet;
+    return count;
 }
 
 /**
- * Deserializes a HostGameState.
+ * Deserializes one of the messages WriteHostGameStateMessages writes, by its type. Returns false if it's too short for
+ * what it says it holds.
  */
-sf::Packet& operator >>(sf::Packet& packet, HostGameState& hostGameState) {
-    unsigned int playerCount;
-    packet >> playerCount;
-    hostGameState.playerGameStates.resize(playerCount);
-    for (unsigned int index = 0; index < playerCount; ++index) {
-        auto& playerGameState = hostGameState.playerGameStates[index];
-        auto& playerPosition = playerGameState.playerPosition;
-        packet >> playerGameState.uniqueId >> playerGameState.name >> playerGameState.currentMap >> playerGameState.walkBikeSurfState
-               >> playerPosition.yPosition >> playerPosition.xPosition 
-               >> playerPosition.yBlockPosition >> playerPosition.xBlockPosition; 
-               
-        for (unsigned int index = 0; index < 0x194; ++index) {
-            packet >> playerGameState.partyMonsters[index];
+bool ReadHostGameStatePart(sf::Packet& packet, PacketType type, HostGameStatePart& part) {
+    unsigned int count;
+    packet >> part.number.sequence >> part.number.sentAt;
+    if (type == PacketType::HOST_PLAYERS) {
+        packet >> part.playerCount >> part.firstPlayer >> count;
+        if (!packet or count > kMaxMessageSize or part.playerCount > kMaxPlayers) return false;
+        part.players.resize(count);
+        for (auto& player : part.players) {
+            auto& playerPosition = player.playerPosition;
+            packet >> player.uniqueId >> player.name >> player.currentMap >> player.walkBikeSurfState
+                   >> playerPosition.yPosition >> playerPosition.xPosition
+                   >> playerPosition.yBlockPosition >> playerPosition.xBlockPosition;
+            player.partyHash = ReadHash(packet);
+            ReadEcho(packet, player.echo);
+        }
+    } else if (type == PacketType::HOST_SPRITES) {
+        packet >> part.hostUniqueId >> part.hostMap >> count;
+        if (!packet or count > kMaxMessageSize) return false;
+        part.sprites.resize(count);
+        for (auto& sprite : part.sprites) {
+            packet >> sprite;
         }
     }
+    return static_cast<bool>(packet);
+}
 
-    unsigned int spriteCount;
-    packet >> spriteCount;
-    hostGameState.sprites.resize(spriteCount);
-    for (unsigned int index = 0; index < spriteCount; ++index) {
-        auto& sprite = hostGameState.sprites[index];
-        packet >> sprite.spriteIndex >> sprite.pictureId >> sprite.moveStatus >> sprite.direction
-               >> sprite.yDisplacement >> sprite.xDisplacement >> sprite.yPosition >> sprite.xPosition
-               >> sprite.canMove >> sprite.inGrass;    
+/**
+ * Serializes a PARTY_REQUEST for the parties with the hashes (at most kMaxPartyRequest of them).
+ */
+void WritePartyRequest(sf::Packet& packet, std::vector<uint64_t> const& hashes) {
+    auto count = std::min(hashes.size(), kMaxPartyRequest);
+    packet << static_cast<int>(PacketType::PARTY_REQUEST) << static_cast<unsigned int>(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        WriteHash(packet, hashes[index]);
+    }
+}
+
+/**
+ * Deserializes a PARTY_REQUEST (after its type). Returns false if it's too short for what it says it holds.
+ */
+bool ReadPartyRequest(sf::Packet& packet, std::vector<uint64_t>& hashes) {
+    unsigned int count;
+    packet >> count;
+    if (!packet or count > kMaxPartyRequest) return false;
+    hashes.resize(count);
+    for (auto& hash : hashes) {
+        hash = ReadHash(packet);
+    }
+    return static_cast<bool>(packet);
+}
+
+/**
+ * Writes PARTIES messages holding the parties with the hashes, as many to a message as fit in kMaxMessageSize bytes,
+ * into messages from the front. Hashes that aren't cached or were already asked for are skipped, and no more than
+ * maxParties are written (as many as there are players to want them), so a small request can't be answered with a
+ * large reply. Returns how many messages it wrote.
+ */
+std::size_t WritePartiesMessages(std::vector<sf::Packet>& messages, std::vector<uint64_t> const& hashes, const PartyCache& cache,
+                                 std::size_t maxParties) {
+    std::size_t const kPartiesPerMessage = (kMaxMessageSize - 8) / kPartySize; // After the type and count
+    std::size_t count = 0;
+    std::vector<Party const*> found;
+    for (auto hash : hashes) {
+        if (found.size() >= maxParties) break;
+        auto party = cache.Find(hash);
+        if (party and std::find(found.begin(), found.end(), party) == found.end()) found.push_back(party);
     }
     
-    return packet;
+    for (std::size_t first = 0; first < found.size(); first += kPartiesPerMessage) {
+        auto last = std::min(found.size(), first + kPartiesPerMessage);
+        auto& message = NextMessage(messages, count);
+        message << static_cast<int>(PacketType::PARTIES) << static_cast<unsigned int>(last - first);
+        for (auto index = first; index < last; ++index) {
+            message.append(found[index]->data(), kPartySize);
+        }
+    }
+    return count;
+}
+
+/**
+ * Deserializes a PARTIES message (after its type). Returns false if it's too short for what it says it holds.
+ */
+bool ReadParties(sf::Packet& packet, std::vector<Party>& parties) {
+    unsigned int count;
+    packet >> count;
+    if (!packet or count > kMaxMessageSize / kPartySize) return false;
+    parties.resize(count);
+    for (auto& party : parties) {
+        for (auto& value : party) {
+            packet >> value;
+        }
+    }
+    return static_cast<bool>(packet);
 }
 
 /**
  * Serializes a Connect Request.
  */
 sf::Packet& operator <<(sf::Packet& packet, const ConnectRequest& connectRequest) {
-    packet << connectRequest.name;
+    packet << connectRequest.name << connectRequest.uniqueId;
     return packet;
 }
 
@@ -167,7 +324,7 @@ sf::Packet& operator <<(sf::Packet& packet, const ConnectRequest& connectRequest
  * Deserializes a Connect Request.
  */
 sf::Packet& operator >>(sf::Packet& packet, ConnectRequest& connectRequest) {
-    packet >> connectRequest.name;
+    packet >> connectRequest.name >> connectRequest.uniqueId;
     return packet;
 }
 
@@ -189,10 +346,24 @@ sf::Packet& operator >>(sf::Packet& packet, ConnectResponse& connectResponse) {
 
 Network::Network() {
     networkMode = NetworkMode::IDLE;
+    isHost = false;
+    uniqueId = 0;
+    hostGameStateReceived = false;
+    inboxWaiting = false;
+    sequence = 0;
+    linkReportInterval = std::chrono::seconds(0);
+    clientTimeout = std::chrono::seconds(5);
+    hostTimeout = std::chrono::seconds(5);
+    connectTimeout = std::chrono::seconds(30);
+    rejoining = false;
+    connectBackoff = kFirstConnectBackoff;
+    connectAttempts = 0;
+    transport = &socket;
 }
 
 void Network::Initialize(MemoryManagementUnit* mmu_, Display* display_, 
-				       Timer* timer_, Processor* cpu_, Input* input_, GameBoy* gameboy_, sf::RenderWindow* window_) {
+				       Timer* timer_, Processor* cpu_, Input* input_, GameBoy* gameboy_, sf::RenderWindow* window_,
+                         PerformanceCounters* counters_) {
     mmu = mmu_;
 	display = display_;
 	timer = timer_;
@@ -200,24 +371,49 @@ void Network::Initialize(MemoryManagementUnit* mmu_, Display* display_,
     input = input_;
     window = window_;
     gameboy = gameboy_;
+    counters = counters_;
     
     inBattle = false;
+    deferredBattleAccept = 0;
     moveSent = false;
     battleTurn = 0;
 }
 
+/**
+ * Sends and receives through the transport (which must outlive the network) instead of a UDP socket, to run peers
+ * together on a LoopbackNetwork. Only before Host or Connect.
+ */
+void Network::UseTransport(Transport* transport_) {
+    transport = transport_;
+}
+
 /**
  * Prepares socket to asynchronously listen on the specified port.
  */
 bool Network::SetupSocket(unsigned short port) {
-    if (socket.bind(port) != sf::Socket::Done) {
+    if (!transport->Bind(port)) {
         return false;
     }
-    socket.setBlocking(false);
+    transport->SetBlocking(false);
     
     return true;
 }
 
+/**
+ * Sends the packet, counting its bytes towards the performance counters.
+ */
+sf::Socket::Status Network::Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) {
+    auto status = transport->Send(packet, address, port);
+    if (status == sf::Socket::Done) {
+        counters->networkBytesOut += packet.getDataSize();
+        auto peer = isHost ? FindClientUniqueId(address, port) : 0;
+        if (peer != -1) {
+            links[peer].bytesOut += packet.getDataSize();
+        }
+    }
+    return status;
+}
+
 
 /**
  * Returns true after successfully acting as host and listening on the specified port.
@@ -238,12 +434,15 @@ bool Network::Host(unsigned short port, const std::string& name) {
     std::srand(std::time(0)); // use current time as seed for random generator
     uniqueId = std::rand();
     std::cout << "Host uniqueId: " << uniqueId << std::endl;
+    StartReceiving();
     return true;
 }
 
 
 /**
- * Returns true after successfully receiving a response from the host.
+ * Starts joining the host's session, returning false if the socket can't be bound. Returns straight away rather than
+ * waiting for the host to answer: ProcessMessages sends the request again until it does (see RetryConnect), so the game
+ * runs alone in the meantime, and on its own for good if the host never answers within connectTimeout.
  */
 bool Network::Connect(sf::IpAddress address, unsigned short hostPort, unsigned short port, std::string name) {
     this->name = name;
@@ -251,70 +450,283 @@ bool Network::Connect(sf::IpAddress address, unsigned short hostPort, unsigned s
     
     std::cout << "Attempting to connect to host while listening on port: " << port << std::endl;
     networkMode = NetworkMode::CONNECTING;
-    if (socket.bind(port) != sf::Socket::Done)
+    if (!transport->Bind(port))
     {
         std::cout << "Failed to bind to socket." << std::endl;
         networkMode = NetworkMode::FAILED_CONNECTING;
         return false;
     }
     
-    // Setup request packet
-    std::cout << "Setting up request packet to send to port: " << hostPort << std::endl;
-    ConnectRequest connectRequest;
-    connectRequest.name = name;
-    sf::Packet connectRequestPacket;
-    connectRequestPacket << static_cast<int>(PacketType::CONNECT_REQUEST) << connectRequest;
+    // Host's NetworkId, until the response says what its uniqueId is
+    NetworkId hostNetworkId;
+    hostNetworkId.uniqueId = 0;
+    hostNetworkId.address = address;
+    hostNetworkId.port = hostPort;
+    hostNetworkId.lastHeard = std::chrono::steady_clock::now();
+    clients[0] = hostNetworkId;
+    clientsByEndpoint[EndpointKey(address, hostPort)] = 0;
     
-    // Send a request to connect to host
-    if (socket.send(connectRequestPacket, address, hostPort) != sf::Socket::Done) {
-        std::cout << "Failed to send connect request." << std::endl;
-        networkMode = NetworkMode::FAILED_CONNECTING;
-        return false;
+    std::cout << "Sending connect request to port: " << hostPort << std::endl;
+    uniqueId = 0;
+    StartReceiving();
+    StartConnecting();
+    return true;
+}
+
+/**
+ * Hands receiving over to the event loop, which decodes packets on its own thread as soon as they arrive. If it can't
+ * be started (or the transport isn't a socket, so there's nothing to wait on), ProcessMessages receives them itself
+ * instead.
+ */
+void Network::StartReceiving() {
+    transport->SetBlocking(false);
+    linksReportedAt = std::chrono::steady_clock::now();
+    if (eventLoop.Running() or transport != &socket) return; // Only a socket can be waited on
+    
+    eventLoop.Watch(socket, [this]() {ReceiveMessages();});
+    if (!eventLoop.Start()) {
+        std::cout << "Failed to start the network event loop, polling the socket instead." << std::endl;
     }
+}
+
+/**
+ * Drains the socket, decoding every packet and stamping it with when it was received, and queues them for
+ * ProcessMessages. Runs on the event loop's thread, so it touches nothing but the socket and the queues.
+ */
+void Network::ReceiveMessages() {
+    auto received = transport->ReceiveBatch(receivedDatagrams);
+    if (received == 0) return;
+    auto receivedAt = std::chrono::steady_clock::now();
+    
+    for (std::size_t index = 0; index < received; ++index) {
+        auto& datagram = receivedDatagrams[index];
+        decoded.emplace_back();
+        auto& message = decoded.back();
+        message.sender = datagram.sender;
+        message.port = datagram.port;
+        message.size = datagram.packet.getDataSize();
+        message.receivedAt = receivedAt;
         
-    // Wait for a response from the host
-    std::cout << "Packet sent, waiting for response." << std::endl;
-    sf::Packet connectResponsePacket;
-    int packetType;
-    while (true) {
-        if (socket.receive(connectResponsePacket, address, port) != sf::Socket::Done) {
-            std::cout << "Failed to receive packet." << std::endl;
-            networkMode = NetworkMode::FAILED_CONNECTING;
-            return false;
+        auto& packet = datagram.packet;
+        int packetType = 0;
+        packet >> packetType;
+        message.type = static_cast<PacketType>(packetType);
+        if (message.type == PacketType::CONNECT_REQUEST) {
+            packet >> message.connectRequest;
+        } else if (message.type == PacketType::CONNECT_RESPONSE) {
+            packet >> message.connectResponse;
+        } else if (message.type == PacketType::NETWORK_GAME_STATE) {
+            packet >> message.gameState;
+        } else if (message.type == PacketType::HOST_PLAYERS or message.type == PacketType::HOST_SPRITES) {
+            if (!ReadHostGameStatePart(packet, message.type, message.hostGameStatePart)) {
+                message.type = PacketType::NONE; // More than it could hold, or than a session can have
+            }
+        } else if (message.type == PacketType::GENERIC_REQUEST) {
+            packet >> message.request;
+        } else if (message.type == PacketType::PARTY_REQUEST) {
+            ReadPartyRequest(packet, message.partyHashes);
+        } else if (message.type == PacketType::PARTIES) {
+            ReadParties(packet, message.parties);
+        }
+        if (!packet) {
+            message.type = PacketType::NONE; // Too short for its type, so it's still counted but never handled
         }
-        connectResponsePacket >> packetType;
-        
-        // Keep looping through until we receive a Connection Response
-        // TODO: Make this asynchronous, otherwise we could be waiting forever on a dropped packet
-        if (packetType == static_cast<int>(PacketType::CONNECT_RESPONSE)) break;
-        std::cout << "Packet type was not CONNECT_RESPONSE, attempting to receive another packet: " << packetType << std::endl;
     }
     
-    connectResponsePacket >> uniqueId;
-    std::cout << "Connection to host successful with unique id: " << uniqueId << std::endl;
-    networkMode = NetworkMode::CONNECTED_AS_CLIENT;
-    socket.setBlocking(false);
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    std::move(decoded.begin(), decoded.end(), std::back_inserter(inbox));
+    inboxWaiting = true;
+    decoded.clear();
+}
+
+/**
+ * Handles every message that arrived since the last call. Called every frame, so requests are acted on within a frame
+ * of arriving rather than waiting for the next Update.
+ */
+void Network::ProcessMessages() {
+    if (networkMode != NetworkMode::CONNECTED_AS_HOST and networkMode != NetworkMode::CONNECTED_AS_CLIENT and
+        networkMode != NetworkMode::CONNECTING) return;
+    if (!eventLoop.Running()) {
+        ReceiveMessages();
+    }
+    if (networkMode == NetworkMode::CONNECTING or rejoining) {
+        RetryConnect(std::chrono::steady_clock::now());
+    }
+    if (!inboxWaiting) return;
     
-    // Store host's NetworkId
-    int serverUniqueId;
-    connectResponsePacket >> serverUniqueId;
-    NetworkId hostNetworkId;
-    hostNetworkId.address = address;
-    hostNetworkId.port = hostPort;
-    clients[0] = hostNetworkId;
-    clients[serverUniqueId] = hostNetworkId;
+    PROFILE_SCOPE(ProfileZone::NETWORK);
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        std::swap(inbox, messages);
+        inboxWaiting = false;
+    }
     
-    return true;
+    auto now = std::chrono::steady_clock::now();
+    for (auto& message : messages) {
+        counters->networkBytesIn += message.size;
+        ++counters->networkMessages;
+        counters->networkMessageWait += std::chrono::duration_cast<std::chrono::nanoseconds>(now - message.receivedAt).count();
+        
+        // Anything from a peer shows they're still there. A client only hears from the host.
+        auto peer = isHost ? FindClientUniqueId(message.sender, message.port) : 0;
+        if (peer != -1) {
+            clients[peer].lastHeard = std::max(clients[peer].lastHeard, message.receivedAt);
+            MeasureLink(message, peer);
+        }
+        HandleMessage(message, peer);
+    }
+    messages.clear();
 }
 
 /**
- * Handle processing any responses received and requests made. Returns null if
- * no updates to state are received.
+ * Handles a message from the peer with the uniqueId (-1 if they aren't a client of the host).
  */
-HostGameState Network::Update(NetworkGameState& localGameState) {
-    //std::cout << "My unique Id: " << uniqueId << std::endl;
-    localGameState.uniqueId = uniqueId;
-    localGameState.name = name;
+void Network::HandleMessage(NetworkMessage& message, int peer) {
+    if (networkMode == NetworkMode::CONNECTING and message.type != PacketType::CONNECT_RESPONSE) {
+        return; // Anything from the host before its response would be about a uniqueId we don't know yet
+    } else if (networkMode == NetworkMode::FAILED_CONNECTING) {
+        return; // Given up on, the rest of what arrived with it is too late
+    }
+    
+    if (message.type == PacketType::CONNECT_REQUEST and isHost) {
+        HandleConnectRequest(message.connectRequest, message.sender, message.port);
+    } else if (message.type == PacketType::NETWORK_GAME_STATE and isHost) {
+        HandleGameState(message, peer);
+    } else if (message.type == PacketType::REJOIN and !isHost and !rejoining) {
+        std::cout << "Host no longer has us as a client, rejoining." << std::endl;
+        rejoining = true;
+        StartConnecting();
+    } else if (message.type == PacketType::CONNECT_RESPONSE and !isHost) {
+        HandleConnectResponse(message.connectResponse);
+    } else if (message.type == PacketType::HOST_PLAYERS and !isHost) {
+        // Update the players' game states, keeping their parties, and where they are in the host's game state
+        auto& part = message.hostGameStatePart;
+        hostPlayerIds.resize(part.playerCount, 0); // At most kMaxPlayers, as ReadHostGameStatePart checks
+        for (std::size_t index = 0; index < part.players.size() and part.firstPlayer + index < hostPlayerIds.size(); ++index) {
+            auto& player = part.players[index];
+            auto& gameState = clientGameStates[player.uniqueId];
+            gameState.uniqueId = player.uniqueId;
+            std::swap(gameState.name, player.name);
+            gameState.currentMap = player.currentMap;
+            gameState.walkBikeSurfState = player.walkBikeSurfState;
+            gameState.playerPosition = player.playerPosition;
+            gameState.partyHash = player.partyHash;
+            ResolveParty(gameState);
+            hostPlayerIds[part.firstPlayer + index] = player.uniqueId;
+        }
+        RequestParties(message.sender, message.port);
+        hostGameStateReceived = true;
+    } else if (message.type == PacketType::HOST_SPRITES and !isHost) {
+        auto& part = message.hostGameStatePart;
+        std::swap(hostSprites, part.sprites);
+        clientGameStates[part.hostUniqueId].uniqueId = part.hostUniqueId;
+        clientGameStates[part.hostUniqueId].currentMap = part.hostMap; // So the sprites are matched to the host's map
+        if (hostPlayerIds.empty()) hostPlayerIds.push_back(0);
+        hostPlayerIds[0] = part.hostUniqueId;
+        hostGameStateReceived = true;
+    } else if (message.type == PacketType::GENERIC_REQUEST) {
+        HandleGenericRequest(message.request, message.sender, message.port);
+    } else if (message.type == PacketType::PARTY_REQUEST or message.type == PacketType::PARTIES) {
+        // Only from a client (or a client's host), as anyone else could be naming someone else to send parties to, or
+        // churning the cache with parties nobody has
+        if ((isHost ? peer : FindClientUniqueId(message.sender, message.port)) == -1) {
+            return;
+        } else if (message.type == PacketType::PARTY_REQUEST) {
+            SendParties(message.partyHashes, message.sender, message.port);
+        } else {
+            ReceiveParties(message.parties);
+        }
+    }
+}
+
+/**
+ * Counts a message towards the link to the peer who sent it, taking its number and any echo of ours in it.
+ */
+void Network::MeasureLink(NetworkMessage const& message, int peer) {
+    auto& link = links[peer];
+    link.bytesIn += message.size;
+    const LinkEcho* echo = nullptr;
+    if (message.type == PacketType::NETWORK_GAME_STATE) {
+        link.Received(message.gameState.number, message.receivedAt);
+        echo = &message.gameState.echo;
+    } else if (message.type == PacketType::HOST_PLAYERS or message.type == PacketType::HOST_SPRITES) {
+        link.Received(message.hostGameStatePart.number, message.receivedAt);
+        for (const auto& player : message.hostGameStatePart.players) {
+            if (player.uniqueId == uniqueId) echo = &player.echo;
+        }
+    }
+    
+    std::chrono::steady_clock::time_point sentAt;
+    if (echo and sendTimes.Find(echo->sequence, sentAt)) {
+        link.RoundTrip(sentAt, *echo, message.receivedAt);
+    }
+}
+
+/**
+ * Fills in the game state's party from the cache, or adds its hash to wantedParties if it isn't cached, keeping the last
+ * party known (marked unresolved) until it arrives.
+ */
+void Network::ResolveParty(NetworkGameState& gameState) {
+    if (auto party = parties.Find(gameState.partyHash)) {
+        gameState.partyMonsters = *party;
+        gameState.partyResolved = true;
+        return;
+    }
+
+    gameState.partyResolved = false;
+    if (std::find(wantedParties.begin(), wantedParties.end(), gameState.partyHash) == wantedParties.end()) {
+        wantedParties.push_back(gameState.partyHash);
+    }
+}
+
+/**
+ * Asks whoever sent the hashes in wantedParties for their parties. Nothing keeps track of what was asked for, as the
+ * hashes are sent again with every game state until the parties arrive.
+ */
+void Network::RequestParties(sf::IpAddress const& address, unsigned short port) {
+    if (wantedParties.empty()) return;
+    sf::Packet requestPacket;
+    WritePartyRequest(requestPacket, wantedParties);
+    Send(requestPacket, address, port);
+    wantedParties.clear();
+}
+
+/**
+ * Answers a PARTY_REQUEST with the parties asked for that are cached. A host is only asked for its players' parties and
+ * its own, and a client only for its own by its host.
+ */
+void Network::SendParties(const std::vector<uint64_t>& hashes, sf::IpAddress const& address, unsigned short port) {
+    auto count = WritePartiesMessages(partyMessages, hashes, parties, isHost ? clients.size() + 1 : 1);
+    for (std::size_t index = 0; index < count; ++index) {
+        Send(partyMessages[index], address, port);
+    }
+}
+
+/**
+ * Caches the parties received, and fills them in for every player whose party they are.
+ */
+void Network::ReceiveParties(std::vector<Party> const& received) {
+    for (const auto& party : received) {
+        auto hash = parties.Insert(party.data());
+        for (auto& gameState : clientGameStates) {
+            if (gameState.second.partyHash == hash) {
+                gameState.second.partyMonsters = party;
+                gameState.second.partyResolved = true;
+            }
+        }
+    }
+}
+
+/**
+ * Handle processing any responses received and requests made. Returns an empty state if
+ * no updates to state are received or this instance isn't networked.
+ */
+HostGameState Network::Update(const GameStateView& localGameState) {
+    PROFILE_SCOPE(ProfileZone::NETWORK);
+    
+    if (linkReportInterval.count() > 0 and std::chrono::steady_clock::now() - linksReportedAt >= linkReportInterval) {
+        ReportLinks(std::cout);
+    }
     
     if (networkMode == NetworkMode::CONNECTED_AS_HOST) {
         auto host = HostUpdate(localGameState);
@@ -337,56 +749,57 @@ HostGameState Network::Update(NetworkGameState& localGameState) {
         
         //return ClientUpdate(localGameState);
     } else {
-        throw;
-    }
-}
-
-HostGameState Network::HostUpdate(const NetworkGameState& localGameState) {
-    // Loop through all pending packets
-    sf::Packet packet;
-    sf::IpAddress sender;
-    unsigned short port;
-    socket.setBlocking(false);
-    auto result = sf::Socket::Done;
-    while (result == sf::Socket::Done) {
-        result = socket.receive(packet, sender, port);
-        if (result == sf::Socket::Done) {
-            int packetType;
-            packet >> packetType;
-            if (packetType == static_cast<int>(PacketType::CONNECT_REQUEST)) {
-                HandleConnectRequest(packet, sender, port);
-            } else if (packetType == static_cast<int>(PacketType::NETWORK_GAME_STATE)) {
-                auto gameState = HandleGameStateResponse(packet, sender, port);
-                clientGameStates[gameState.uniqueId] = gameState;
-            } else if (packetType == static_cast<int>(PacketType::GENERIC_REQUEST)) {
-                //std::cout << "Handling generic request packet" << std::endl;
-                HandleGenericRequestPacket(packet, sender, port);
-            }
-        } else if (result == sf::Socket::Disconnected) {
-            // TODO Reconnect
-        } else if (result == sf::Socket::Error) {
-            // Do Nothing
-        }
+        // Not part of a session (never started networking, still connecting or failed to connect), so play on alone
+        return HostGameState();
     }
+}
+
+HostGameState Network::HostUpdate(const GameStateView& localGameState) {
+    auto now = std::chrono::steady_clock::now();
+    EvictSilentClients(now);
     
-    // Send Host Game State to all clients
+    // Send Host Game State to all clients. The host keeps its own entry (without sprites, which only clients need) to
+    // draw the other players with, but its sprites go out straight from WRAM.
     HostGameState hostGameState;
-    hostGameState.sprites = localGameState.sprites;
-    hostGameState.playerGameStates.push_back(localGameState); // Host is the first
+    NetworkGameState hostPlayerState;
+    hostPlayerState.uniqueId = uniqueId;
+    hostPlayerState.name = name;
+    hostPlayerState.currentMap = localGameState.CurrentMap();
+    hostPlayerState.walkBikeSurfState = localGameState.WalkBikeSurfState();
+    hostPlayerState.playerPosition = localGameState.Position();
+    hostPlayerState.partyHash = parties.Insert(localGameState.PartyMonsters());
+    std::copy_n(localGameState.PartyMonsters(), hostPlayerState.partyMonsters.size(), hostPlayerState.partyMonsters.begin());
+    hostPlayerState.partyResolved = true;
+    hostGameState.playerGameStates.push_back(std::move(hostPlayerState)); // Host is the first
     for (const auto& gameState : clientGameStates) {
         hostGameState.playerGameStates.push_back(gameState.second);
+        auto link = links.find(gameState.first);
+        hostGameState.playerGameStates.back().echo = link != links.end() ? link->second.Echo(now) : LinkEcho{0, 0};
     }
     
     //TestPacket(hostGameState);
     
-    sf::Packet hostGameStatePacket;
-    hostGameStatePacket << static_cast<int>(PacketType::HOST_GAME_STATE) << hostGameState;
+    hostPlayers.clear();
+    for (const auto& playerGameState : hostGameState.playerGameStates) {
+        hostPlayers.push_back(&playerGameState);
+    }
+    auto messageCount = WriteHostGameStateMessages(hostGameStateMessages, hostPlayers, &localGameState, sequence);
     
-    int index = 0;
+    clientEndpoints.clear();
+    for (const auto& client : clients) {
+        clientEndpoints.push_back({client.second.address, client.second.port});
+    }
+    std::size_t bytesPerClient = 0;
+    for (std::size_t index = 0; index < messageCount; ++index) {
+        auto& message = hostGameStateMessages[index];
+        auto sent = transport->SendToAll(message, clientEndpoints);
+        counters->networkBytesOut += sent * message.getDataSize();
+        datagramSizes.Add(message.getDataSize(), sent);
+        sendTimes.Record(sequence - static_cast<uint32_t>(messageCount - 1 - index), now);
+        bytesPerClient += message.getDataSize();
+    }
     for (const auto& client : clients) {
-        const auto& networkId = client.second;
-        socket.send(hostGameStatePacket, networkId.address, networkId.port);
-        ++index;
+        links[client.first].bytesOut += bytesPerClient; // As if every send succeeded, which on a socket they all but always do
     }
     
     // Process pending requests
@@ -396,81 +809,128 @@ HostGameState Network::HostUpdate(const NetworkGameState& localGameState) {
 }
 
 /**
- * For a connect request from the client, adds them to the client list and responds with their uniqueId.
+ * For a connect request from the client, adds them to the client list and responds with their uniqueId. A client asking
+ * again (their response was lost) gets the same uniqueId back, and one rejoining after being evicted gets the one they
+ * asked for, unless someone else has it by now. No one new is answered once the session has kMaxPlayers.
  */
-void Network::HandleConnectRequest(sf::Packet requestPacket, sf::IpAddress sender, unsigned short port) {
+void Network::HandleConnectRequest(const ConnectRequest& request, sf::IpAddress sender, unsigned short port) {
     std::cout << "Handling connection request." << std::endl;
     // Respond with a uniqueId and add the requester to the client listen
     ConnectResponse response;
-    std::srand(std::time(0)); // use current time as seed for random generator
-    response.uniqueId = std::rand();
     response.serverUniqueId = uniqueId;
-    
-    // Create client Id and add to client list
-    NetworkId clientId;
-    std::string name;
-    requestPacket >> name;
-    clientId.uniqueId = response.uniqueId;
-    clientId.name = name;
-    clientId.address = sender;
-    clientId.port = port;
-    clients[clientId.uniqueId] = clientId;
+    response.uniqueId = FindClientUniqueId(sender, port);
+    if (response.uniqueId == -1 and clients.size() + 1 >= kMaxPlayers) {
+        std::cout << "Session full, not answering " << request.name << "." << std::endl;
+        return;
+    } else if (response.uniqueId == -1) {
+        if (request.uniqueId != 0 and request.uniqueId != uniqueId and !clients.count(request.uniqueId)) {
+            response.uniqueId = request.uniqueId;
+        } else {
+            // Seeded once by Host, so requests arriving in the same second still get different ones
+            do {
+                response.uniqueId = std::rand();
+            } while (response.uniqueId == 0 or response.uniqueId == uniqueId or clients.count(response.uniqueId));
+        }
+        
+        // Create client Id and add to client list
+        NetworkId clientId;
+        clientId.uniqueId = response.uniqueId;
+        clientId.name = request.name;
+        clientId.address = sender;
+        clientId.port = port;
+        clients[clientId.uniqueId] = clientId;
+        clientsByEndpoint[EndpointKey(sender, port)] = clientId.uniqueId;
+    }
+    clients[response.uniqueId].lastHeard = std::chrono::steady_clock::now();
     
     // Send response to client with uniqueId
-    std::cout << "Sending response to client for uniqueId: " << clientId.uniqueId << std::endl;
+    std::cout << "Sending response to client for uniqueId: " << response.uniqueId << std::endl;
     sf::Packet connectResponsePacket;
     connectResponsePacket << static_cast<int>(PacketType::CONNECT_RESPONSE) << response;
-    socket.send(connectResponsePacket, sender, port);
+    Send(connectResponsePacket, sender, port);
     std::cout << "Connection response sent." << std::endl;
 }
 
 /**
- * Handle's the client's game state packet and returns the game state they sent here.
+ * Keeps the game state a client sent, if it's their own. Anyone else sending one has been evicted (or the host started
+ * again without them), so they're asked to rejoin.
+ */
+void Network::HandleGameState(NetworkMessage& message, int peer) {
+    if (peer == -1 or message.gameState.uniqueId != peer) {
+        sf::Packet rejoinPacket;
+        rejoinPacket << static_cast<int>(PacketType::REJOIN);
+        Send(rejoinPacket, message.sender, message.port);
+        return;
+    }
+    
+    auto& gameState = clientGameStates[peer];
+    std::swap(gameState, message.gameState);
+    std::swap(gameState.partyMonsters, message.gameState.partyMonsters); // Game states carry no party, so keep the last
+    ResolveParty(gameState);
+    RequestParties(message.sender, message.port);
+}
+
+/**
+ * Drops every client not heard from in clientTimeout, with their game state, link and any requests for them, so nothing
+ * more is sent to them or about them. If they're still there, they'll be asked to rejoin when their next game state
+ * arrives.
  */
-NetworkGameState Network::HandleGameStateResponse(sf::Packet gameStatePacket, sf::IpAddress sender, unsigned short port) {
-    NetworkGameState clientGameState;
-    gameStatePacket >> clientGameState; // TODO: Need to validate this against the IP Address and Port
-    return clientGameState;
+void Network::EvictSilentClients(std::chrono::steady_clock::time_point now) {
+    for (auto client = clients.begin(); client != clients.end();) {
+        if (now - client->second.lastHeard < clientTimeout) {
+            ++client;
+            continue;
+        }
+        
+        auto clientUniqueId = client->first;
+        std::cout << "Client timed out: " << client->second.name << " (" << clientUniqueId << ")" << std::endl;
+        clientGameStates.erase(clientUniqueId);
+        links.erase(clientUniqueId);
+        reportedLinks.erase(clientUniqueId);
+        pendingRequests.erase(std::remove_if(pendingRequests.begin(), pendingRequests.end(),
+                                             [clientUniqueId](const GenericRequestResponse& request) {
+                                                 return request.data[0] == clientUniqueId;
+                                             }),
+                              pendingRequests.end());
+        if (deferredBattleAccept == clientUniqueId) deferredBattleAccept = 0;
+        auto endpoint = clientsByEndpoint.find(EndpointKey(client->second.address, client->second.port));
+        if (endpoint != clientsByEndpoint.end() and endpoint->second == clientUniqueId) clientsByEndpoint.erase(endpoint);
+        client = clients.erase(client);
+    }
 }
 
 /**
- * Receives 
+ * Sends the local game state to the host. Returns the host's game state as far as it's known, if any of it arrived since
+ * the last update, or an empty one if none did.
  */
-HostGameState Network::ClientUpdate(const NetworkGameState& localGameState) {
-    // Loop through all pending packets
+HostGameState Network::ClientUpdate(const GameStateView& localGameState) {
+    auto now = std::chrono::steady_clock::now();
+    if (!rejoining and now - clients[0].lastHeard >= hostTimeout) {
+        LoseHost();
+    }
+    if (rejoining) {
+        return HostGameState(); // ProcessMessages is asking the host to take us back
+    }
+    
     HostGameState hostGameState;
-    sf::Packet packet;
-    sf::IpAddress sender;
-    unsigned short port;
-    auto result = sf::Socket::Done;
-    socket.setBlocking(false);
-    while (result == sf::Socket::Done) {
-        result = socket.receive(packet, sender, port);
-        if (result == sf::Socket::Done) {
-            int packetType;
-            packet >> packetType;
-            if (packetType == static_cast<int>(PacketType::CONNECT_RESPONSE)) {
-                HandleConnectResponse(packet, sender, port);
-            } else if (packetType == static_cast<int>(PacketType::HOST_GAME_STATE)) {
-                packet >> hostGameState;
-                // Update all client game states
-                for (const auto& gameState : hostGameState.playerGameStates) {
-                    clientGameStates[gameState.uniqueId] = gameState;
-                }
-            } else if (packetType == static_cast<int>(PacketType::GENERIC_REQUEST)) {
-                HandleGenericRequestPacket(packet, sender, port);
+    if (hostGameStateReceived) {
+        for (auto playerId : hostPlayerIds) {
+            if (playerId != 0) {
+                hostGameState.playerGameStates.push_back(clientGameStates[playerId]);
             }
-        } else if (result == sf::Socket::Disconnected) {
-            // TODO
-        } else if (result == sf::Socket::Error) {
-            // Do Nothing
         }
+        hostGameState.sprites = hostSprites;
+        hostGameStateReceived = false;
     }
     
     sf::Packet localGameStatePacket;
-    localGameStatePacket << static_cast<int>(PacketType::NETWORK_GAME_STATE) << localGameState;
+    localGameStatePacket << static_cast<int>(PacketType::NETWORK_GAME_STATE);
+    auto partyHash = parties.Insert(localGameState.PartyMonsters()); // Cached to answer whoever asks for it
+    PacketNumber number{++sequence, LinkClock()};
+    sendTimes.Record(sequence, now);
+    WriteGameState(localGameStatePacket, uniqueId, name, localGameState, partyHash, number, links[0].Echo(now));
     const auto& networkId = clients[0];
-    socket.send(localGameStatePacket, networkId.address, networkId.port);
+    Send(localGameStatePacket, networkId.address, networkId.port);
     
     // Process pending requests
     HandlePendingRequests();
@@ -479,9 +939,13 @@ HostGameState Network::ClientUpdate(const NetworkGameState& localGameState) {
 }
 
 /**
- * Sends out all pending requests.
+ * Sends out all pending requests, after accepting a battle that was waiting on the player's party if it has arrived.
  */
 void Network::HandlePendingRequests() {
+    if (deferredBattleAccept != 0) {
+        AcceptBattleRequest(deferredBattleAccept);
+    }
+    
     std::stack<std::size_t> requestsToRemove;
     for (std::size_t index = 0; index < pendingRequests.size(); ++index) {
         auto& pendingRequest = pendingRequests[index];
@@ -492,18 +956,103 @@ void Network::HandlePendingRequests() {
             sf::Packet requestPacket;
             requestPacket << static_cast<int>(PacketType::GENERIC_REQUEST) << pendingRequest;
             const auto& networkId = clients[pendingRequest.data[0]];
-            socket.send(requestPacket, networkId.address, networkId.port);
+            Send(requestPacket, networkId.address, networkId.port);
         }
     }
 }
 
 /**
- * Accepts connect response from host.
+ * Accepts connect response from host, finishing connecting or rejoining. Any other is a duplicate of one already taken,
+ * answering a request that was sent again.
  */
-void Network::HandleConnectResponse(sf::Packet gameStatePacket, sf::IpAddress sender, unsigned short port) {
-    // TODO: Normally this should only be handled during the connect phase, but need to account for this
-    // on a re-sent UDP packet for example.
-    throw;
+void Network::HandleConnectResponse(const ConnectResponse& response) {
+    if (networkMode == NetworkMode::CONNECTING) {
+        std::cout << "Connection to host successful with unique id: " << response.uniqueId << std::endl;
+        networkMode = NetworkMode::CONNECTED_AS_CLIENT;
+    } else if (!rejoining) {
+        return;
+    } else if (response.uniqueId != uniqueId) {
+        std::cout << "Rejoined host with a new unique id: " << response.uniqueId << std::endl;
+    } else {
+        std::cout << "Rejoined host with unique id: " << uniqueId << std::endl;
+    }
+    uniqueId = response.uniqueId;
+    rejoining = false;
+    
+    // The host may have started again with a new uniqueId, and numbers its messages from 1 again if so
+    auto hostNetworkId = clients[0];
+    clients.clear();
+    hostNetworkId.uniqueId = response.serverUniqueId;
+    hostNetworkId.lastHeard = std::chrono::steady_clock::now();
+    clients[0] = hostNetworkId;
+    clients[response.serverUniqueId] = hostNetworkId;
+    clientsByEndpoint.clear();
+    clientsByEndpoint[EndpointKey(hostNetworkId.address, hostNetworkId.port)] = response.serverUniqueId;
+    links.erase(0);
+    reportedLinks.erase(0);
+}
+
+/**
+ * Forgets everyone's game state when the host hasn't been heard from in hostTimeout, so other players aren't drawn
+ * frozen where they were, and starts asking to rejoin.
+ */
+void Network::LoseHost() {
+    std::cout << "Lost connection to host, rejoining." << std::endl;
+    rejoining = true;
+    clientGameStates.clear();
+    hostPlayerIds.clear();
+    hostSprites.clear();
+    hostGameStateReceived = false;
+    StartConnecting();
+}
+
+/**
+ * Sends the first connect request, for RetryConnect to send again until the host answers.
+ */
+void Network::StartConnecting() {
+    auto now = std::chrono::steady_clock::now();
+    connectStartedAt = now;
+    connectAttempts = 0;
+    connectBackoff = kFirstConnectBackoff;
+    SendConnectRequest(now);
+}
+
+/**
+ * Asks the host to connect, with the uniqueId we had if rejoining, and schedules the next attempt. The wait before it is
+ * randomized by a quarter either way, so clients that lost the host together don't all ask again together.
+ */
+void Network::SendConnectRequest(std::chrono::steady_clock::time_point now) {
+    ConnectRequest request;
+    request.name = name;
+    request.uniqueId = uniqueId;
+    sf::Packet requestPacket;
+    requestPacket << static_cast<int>(PacketType::CONNECT_REQUEST) << request;
+    const auto& networkId = clients[0];
+    if (Send(requestPacket, networkId.address, networkId.port) != sf::Socket::Done) {
+        std::cout << "Failed to send connect request." << std::endl;
+    }
+    
+    ++connectAttempts;
+    auto spread = connectBackoff.count() / 2;
+    nextConnectAttempt = now + connectBackoff - std::chrono::milliseconds(spread / 2)
+                       + std::chrono::milliseconds(spread > 0 ? std::rand() % spread : 0);
+    connectBackoff = std::min(connectBackoff * 2, kMaxConnectBackoff);
+}
+
+/**
+ * Sends the connect request again once the last has gone unanswered for its backoff. Connecting gives up at
+ * connectTimeout and plays on alone; rejoining keeps asking, in case the host comes back.
+ */
+void Network::RetryConnect(std::chrono::steady_clock::time_point now) {
+    if (networkMode == NetworkMode::CONNECTING and now - connectStartedAt >= connectTimeout) {
+        std::cout << "No response from host after " << connectAttempts << " connect requests, playing alone." << std::endl;
+        networkMode = NetworkMode::FAILED_CONNECTING;
+        eventLoop.Stop();
+        return;
+    }
+    if (now >= nextConnectAttempt) {
+        SendConnectRequest(now);
+    }
 }
 
 /**
@@ -525,11 +1074,19 @@ void Network::CreateBattleRequest(int targetUniqueId) {
 }
 
 /**
- * Creates a pending request accepting a battle request.
+ * Creates a pending request accepting a battle request. If the player's party hasn't arrived yet (it's asked for with
+ * each of their game states until it does), the battle is accepted once it has.
  */
 void Network::AcceptBattleRequest(int targetUniqueId) {
     if (inBattle) return;
     
+    auto target = clientGameStates.find(targetUniqueId);
+    if (target == clientGameStates.end() or !target->second.partyResolved) {
+        deferredBattleAccept = targetUniqueId;
+        return;
+    }
+    deferredBattleAccept = 0;
+    
     // Remove old pending requests
     pendingRequests.clear();
     
@@ -541,7 +1098,7 @@ void Network::AcceptBattleRequest(int targetUniqueId) {
     pendingRequests.push_back(acceptBattleRequest);
     
     // Start the battle in the meantime
-    mmu->SetPartyMonsters(clientGameStates[targetUniqueId].partyMonsters, true);
+    mmu->SetPartyMonsters(target->second.partyMonsters, true);
     gameboy->InitiateBattle();
     inBattle = true;
     mmu->isBattleInitiator = false;
@@ -581,9 +1138,7 @@ void Network::RemovePendingRequest(ResponseType responseType, int remotePlayerId
 /**
  * Process any incoming GENERIC_REQUEST packets.
  */
-void Network::HandleGenericRequestPacket(sf::Packet& packet, sf::IpAddress sender, unsigned short port) {
-    GenericRequestResponse genericRequestResponse;
-    packet >> genericRequestResponse;
+void Network::HandleGenericRequest(const GenericRequestResponse& genericRequestResponse, sf::IpAddress sender, unsigned short port) {
     if (genericRequestResponse.responseType == ResponseType::REQUEST_BATTLE) {
         // Remote player has requested battle; open dialogue requesting battle
         //std::cout << "Remote Player has requested battle" << std::endl;
@@ -607,6 +1162,11 @@ void Network::HandleGenericRequestPacket(sf::Packet& packet, sf::IpAddress sende
         RemovePendingRequest(ResponseType::REQUEST_BATTLE, remotePlayerId);
     } else if (!inBattle and genericRequestResponse.responseType == ResponseType::ACCEPT_BATTLE_REQUEST) {
         // Battle Accepted by remote player, initiate battle
+        int remotePlayerId = FindClientUniqueId(sender, port);
+        auto remote = clientGameStates.find(remotePlayerId);
+        if (remote == clientGameStates.end() or !remote->second.partyResolved) {
+            return; // Their party is still being asked for, and they send the acceptance again until the battle starts
+        }
         
         // Remove old pending requests
         pendingRequests.clear();
@@ -614,8 +1174,7 @@ void Network::HandleGenericRequestPacket(sf::Packet& packet, sf::IpAddress sende
         //std::cout << "Player accepted battle" << std::endl;
         input->dialogueWithPlayer = PlayerDialogue::NOT_IN_DIALOGUE;
         
-        int remotePlayerId = FindClientUniqueId(sender, port);
-        mmu->SetPartyMonsters(clientGameStates[remotePlayerId].partyMonsters, true);
+        mmu->SetPartyMonsters(remote->second.partyMonsters, true);
         
         gameboy->InitiateBattle();
         inBattle = true;
@@ -648,17 +1207,39 @@ void Network::HandleGenericRequestPacket(sf::Packet& packet, sf::IpAddress sende
 }
 
 /**
- * Returns the uniqueId for the given IpAddress and Port. -1 is returned if none is found.
+ * Prints how big the game state messages sent so far were, if any were.
  */
-int Network::FindClientUniqueId(sf::IpAddress sender, unsigned short port) {
-    for (const auto& client : clients) {
-        const auto& networkId = client.second;
-        if (networkId.address == sender and networkId.port == port) {
-            return client.first;
+void Network::ReportDatagramSizes(std::ostream& output) const {
+    if (datagramSizes.Total() > 0) {
+        datagramSizes.Write(output);
+    }
+}
+
+/**
+ * Prints every link's round trip and jitter, and its loss and byte rates since the last report.
+ */
+void Network::ReportLinks(std::ostream& output) {
+    auto now = std::chrono::steady_clock::now();
+    auto seconds = std::chrono::duration<double>(now - linksReportedAt).count();
+    for (const auto& link : links) {
+        if (isHost) {
+            output << "Link to " << clients[link.first].name << " (" << link.first << ")\t";
+        } else {
+            output << "Link to host\t";
         }
+        link.second.Write(output, reportedLinks[link.first], seconds);
     }
-    
-    return -1;
+    reportedLinks = links;
+    linksReportedAt = now;
+}
+
+/**
+ * Returns the uniqueId for the given IpAddress and Port (the host's, for a client, once it has answered). -1 is returned
+ * if none is found.
+ */
+int Network::FindClientUniqueId(sf::IpAddress sender, unsigned short port) {
+    auto client = clientsByEndpoint.find(EndpointKey(sender, port));
+    return client != clientsByEndpoint.end() ? client->second : -1;
 }
 
 /**
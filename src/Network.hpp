@@ -12,17 +12,26 @@
 #include <SFML/System.hpp>
 
 #include <unordered_map>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <ctime>
+#include <mutex>
 #include <stack>
 
+#include "DatagramTransport.hpp"
+#include "EventLoop.hpp"
+#include "LinkStats.hpp"
+#include "PartyCache.hpp"
+
 class MemoryManagementUnit;
 class Display;
 class Timer;
 class Processor;
 class Input;
 class GameBoy;
+struct PerformanceCounters;
 
 /**
  * Holds information regarding each client/server on the network.
@@ -32,6 +41,7 @@ struct NetworkId {
     std::string name;
     sf::IpAddress address;
     unsigned short port;
+    std::chrono::steady_clock::time_point lastHeard; // When anything last arrived from them
 };
 
 /**
@@ -70,7 +80,62 @@ struct NetworkGameState {
     int walkBikeSurfState;
     PlayerPosition playerPosition;
     std::vector<SpriteState> sprites;
-    std::array<uint8_t, 0x194> partyMonsters; // The player's pokemon party from 0xd163 to 0xd273
+    uint64_t partyHash; // Sent instead of the party, which is looked up by it in a PartyCache
+    Party partyMonsters; // The player's pokemon party from 0xd163 to 0xd273, once it's known
+    bool partyResolved; // Whether partyMonsters is partyHash's party, rather than the last one known (or none) until it arrives
+    PacketNumber number; // NETWORK_GAME_STATE only, as the player numbered it
+    LinkEcho echo; // In NETWORK_GAME_STATE, the player's echo of the host's messages; in HOST_PLAYERS, the host's of theirs
+};
+
+/**
+ * Reads one of the sprites' state straight from the sprite tables in WRAM (0xC1X0 and 0xC2X0), rather than from a copy
+ * in a SpriteState.
+ */
+class SpriteView {
+public:
+    SpriteView(uint8_t const* wram, uint8_t spriteIndex)
+        : spriteIndex(spriteIndex)
+        , table1(wram + ((0xC100 + spriteIndex * 0x10) & 0x1FFF))
+        , table2(wram + ((0xC200 + spriteIndex * 0x10) & 0x1FFF)) {
+    }
+    
+    uint8_t SpriteIndex() const {return spriteIndex;}
+    uint8_t PictureId() const {return table1[0x0];}
+    uint8_t MoveStatus() const {return table1[0x1];}
+    uint8_t Direction() const {return table1[0x9];}
+    uint8_t YDisplacement() const {return table2[0x2];}
+    uint8_t XDisplacement() const {return table2[0x3];}
+    uint8_t YPosition() const {return table2[0x4];}
+    uint8_t XPosition() const {return table2[0x5];}
+    uint8_t CanMove() const {return table2[0x6];}
+    uint8_t InGrass() const {return table2[0x7];}
+    
+private:
+    uint8_t spriteIndex;
+    uint8_t const* table1; // 0xC1X0
+    uint8_t const* table2; // 0xC2X0
+};
+
+/**
+ * The local player's game state, read from WRAM as it's serialized instead of being copied into a NetworkGameState
+ * every update. Only valid while the emulation isn't running.
+ */
+class GameStateView {
+public:
+    static unsigned int const kSpriteCount = 16;
+    
+    explicit GameStateView(std::vector<uint8_t> const& wram) : wram(wram.data()) {}
+    
+    int CurrentMap() const {return wram[0xD35E & 0x1FFF];}
+    int WalkBikeSurfState() const {return wram[0xD700 & 0x1FFF];}
+    PlayerPosition Position() const {
+        return {wram[0xD361 & 0x1FFF], wram[0xD362 & 0x1FFF], wram[0xD363 & 0x1FFF], wram[0xD364 & 0x1FFF]};
+    }
+    SpriteView Sprite(unsigned int index) const {return SpriteView(wram, static_cast<uint8_t>(index));}
+    uint8_t const* PartyMonsters() const {return wram + (0xD163 & 0x1FFF);} // 0x194 bytes, as in NetworkGameState
+    
+private:
+    uint8_t const* wram;
 };
 
 /**
@@ -88,11 +153,47 @@ enum class PacketType {
     CONNECT_REQUEST = 1,
     CONNECT_RESPONSE = 2,
     NETWORK_GAME_STATE = 3,
-    HOST_GAME_STATE = 4,
+    HOST_GAME_STATE = 4, // No longer sent, split into HOST_PLAYERS and HOST_SPRITES
     GENERIC_REQUEST = 5,
+    HOST_PLAYERS = 6,
+    PARTIES = 7, // Sent either way, in answer to a PARTY_REQUEST
+    HOST_SPRITES = 8,
+    PARTY_REQUEST = 9, // The hashes of parties that aren't cached, sent to whoever sent them
+    REJOIN = 10, // Sent by the host to whoever sends it a game state without being a client (they timed out)
     NONE
 };
 
+/**
+ * The most a message is built to take, under the MTU of most paths (1500 bytes on Ethernet, less for tunnels and PPPoE)
+ * with room for the IP and UDP headers, so messages aren't fragmented. Any fragment lost loses the whole message.
+ */
+std::size_t const kMaxMessageSize = 1200;
+
+/**
+ * The most hashes in one PARTY_REQUEST, which fits in kMaxMessageSize bytes.
+ */
+std::size_t const kMaxPartyRequest = 128;
+
+/**
+ * The most players in a session, counting a host that plays. Hosts and relays turn away anyone connecting past it, and
+ * clients ignore HOST_PLAYERS claiming more.
+ */
+std::size_t const kMaxPlayers = 1024;
+
+/**
+ * One of the messages a HostGameState is sent as (see WriteHostGameStateMessages). Each can be applied without the
+ * others, so losing one loses only what's in it.
+ */
+struct HostGameStatePart {
+    PacketNumber number; // Every message is numbered, HOST_PLAYERS and HOST_SPRITES alike
+    unsigned int playerCount; // HOST_PLAYERS, how many players are in the whole HostGameState
+    unsigned int firstPlayer; // HOST_PLAYERS, the index of players[0] in the HostGameState
+    std::vector<NetworkGameState> players; // HOST_PLAYERS with everything but parties (only their hashes)
+    int hostUniqueId; // HOST_SPRITES, along with the map the sprites are on
+    int hostMap;
+    std::vector<SpriteState> sprites; // HOST_SPRITES
+};
+
 /**
  * Indicates what mode the network is in.
  */
@@ -110,6 +211,7 @@ enum class NetworkMode {
  */
 struct ConnectRequest {
     std::string name;
+    int uniqueId; // The one the client had before, to rejoin with, or 0 for a new one
 };
 
 /**
@@ -140,6 +242,44 @@ struct GenericRequestResponse {
     std::vector<int> data; // Usually only contains one value, the target player unique id
 };
 
+/**
+ * A packet as decoded by the event loop when it arrived, waiting to be handled on the game's thread. Only the member for
+ * its type is filled in.
+ */
+struct NetworkMessage {
+    PacketType type;
+    sf::IpAddress sender;
+    unsigned short port;
+    std::size_t size; // Bytes received
+    std::chrono::steady_clock::time_point receivedAt;
+    
+    ConnectRequest connectRequest;
+    ConnectResponse connectResponse;
+    NetworkGameState gameState;
+    HostGameStatePart hostGameStatePart;
+    GenericRequestResponse request;
+    std::vector<uint64_t> partyHashes; // PARTY_REQUEST
+    std::vector<Party> parties; // PARTIES
+};
+
+// Serialization shared with the relay server (see Relay) and the clients SwarmLoad impersonates
+void WriteGameState(sf::Packet& packet, int uniqueId, const std::string& name, const GameStateView& gameState, uint64_t partyHash,
+                    const PacketNumber& number, const LinkEcho& echo);
+sf::Packet& operator >>(sf::Packet& packet, NetworkGameState& networkGameState);
+sf::Packet& operator <<(sf::Packet& packet, const ConnectRequest& connectRequest);
+sf::Packet& operator >>(sf::Packet& packet, ConnectRequest& connectRequest);
+sf::Packet& operator <<(sf::Packet& packet, const ConnectResponse& connectResponse);
+sf::Packet& operator >>(sf::Packet& packet, ConnectResponse& connectResponse);
+sf::Packet& operator <<(sf::Packet& packet, const GenericRequestResponse& genericRequestResponse);
+bool ReadHostGameStatePart(sf::Packet& packet, PacketType type, HostGameStatePart& part);
+std::size_t WriteHostGameStateMessages(std::vector<sf::Packet>& messages, std::vector<const NetworkGameState*> const& players,
+                                       const GameStateView* hostSprites, uint32_t& sequence);
+void WritePartyRequest(sf::Packet& packet, std::vector<uint64_t> const& hashes);
+bool ReadPartyRequest(sf::Packet& packet, std::vector<uint64_t>& hashes);
+std::size_t WritePartiesMessages(std::vector<sf::Packet>& messages, std::vector<uint64_t> const& hashes, const PartyCache& cache,
+                                 std::size_t maxParties);
+bool ReadParties(sf::Packet& packet, std::vector<Party>& parties);
+
 /**
  * Handles server and client communication.
  */
@@ -148,17 +288,21 @@ public:
     Network();
 
     void Initialize(MemoryManagementUnit* mmu_, Display* display_, 
-				    Timer* timer_, Processor* cpu_, Input* input_, GameBoy* gameboy_, sf::RenderWindow* window_);
+				    Timer* timer_, Processor* cpu_, Input* input_, GameBoy* gameboy_, sf::RenderWindow* window_,
+                    PerformanceCounters* counters_);
+    void UseTransport(Transport* transport_);
                     
     bool Host(unsigned short port, const std::string& name);
     bool Connect(sf::IpAddress address, unsigned short hostPort, unsigned short port, std::string name);
-    HostGameState Update(NetworkGameState& localGameState);
+    void ProcessMessages();
+    HostGameState Update(const GameStateView& localGameState);
 
     NetworkMode networkMode;
     bool isHost;
     int uniqueId;
     std::vector<GenericRequestResponse> pendingRequests; // Treat this as a iterable queue
     bool inBattle;
+    int deferredBattleAccept; // The uniqueId of a player whose battle was accepted before their party arrived, or 0
     bool moveSent;
     int battleTurn;
     
@@ -167,6 +311,22 @@ public:
     void RefuseBattleRequest(int targetUniqueId);
     void SendPlayerMove(int targetUniqueId, int move, int action, int whichPokemon);
     
+    void ReportDatagramSizes(std::ostream& output) const;
+    
+    /**
+     * The link to each peer by their uniqueId: every client's for the host, the host's (under 0, as in clients) for a
+     * client. Only to be read on the game's thread.
+     */
+    std::unordered_map<int, LinkStats> const& Links() const {return links;}
+    void ReportLinks(std::ostream& output);
+    std::chrono::seconds linkReportInterval; // How often Update prints ReportLinks, never if 0
+    
+    // Every peer sends the other something every update (game states one way, the host's the other), so going longer
+    // than these without hearing from one means they're gone: the host evicts a client, a client asks to rejoin
+    std::chrono::milliseconds clientTimeout;
+    std::chrono::milliseconds hostTimeout;
+    std::chrono::milliseconds connectTimeout; // How long Connect keeps asking before giving up and playing alone
+    
 private:
     MemoryManagementUnit* mmu;
 	Display* display;
@@ -175,26 +335,78 @@ private:
     Input* input;
 	GameBoy* gameboy;
     sf::RenderWindow* window;
+    PerformanceCounters* counters;
     
-    sf::UdpSocket socket;
+    DatagramTransport socket;
+    Transport* transport; // socket, unless UseTransport gave another
+    std::vector<ReceivedDatagram> receivedDatagrams; // The event loop's, reused for every batch it receives
+    std::vector<DatagramEndpoint> clientEndpoints; // Where the host's game state goes, rebuilt every update
     std::string name;
     std::unordered_map<int, NetworkId> clients; // UniqueId, NetworkId
                                                 // NOTE: This only holds 1 element (0) if you are a client (the host's NetworkId)
+    std::unordered_map<uint64_t, int> clientsByEndpoint; // Address and port (see EndpointKey), UniqueId, kept alongside clients
     std::unordered_map<int, NetworkGameState> clientGameStates; // UniqueId, NetworkGameState
     
+    std::vector<sf::Packet> hostGameStateMessages; // The host's, reused for every update
+    std::vector<const NetworkGameState*> hostPlayers; // The host's, for writing hostGameStateMessages
+    DatagramSizeHistogram datagramSizes; // Of game states sent
+    
+    std::vector<int> hostPlayerIds; // The players in the host's game state, in order (0 where they haven't arrived)
+    std::vector<SpriteState> hostSprites; // The latest from the host
+    bool hostGameStateReceived; // Whether any part of the host's game state arrived since the last ClientUpdate
+    
+    std::unordered_map<int, LinkStats> links; // Keyed as clients
+    std::unordered_map<int, LinkStats> reportedLinks; // links at the last ReportLinks, to print the change since
+    std::chrono::steady_clock::time_point linksReportedAt;
+    uint32_t sequence; // Of the last message numbered, game states for a client and each of the host's messages for the host
+    SendTimes sendTimes; // Of the messages numbered, for the round trips to whoever echoes them
+    
+    bool rejoining; // A client that lost the host (or was evicted), asking to connect again instead of sending game states
+    std::chrono::steady_clock::time_point connectStartedAt; // Of connecting or rejoining
+    std::chrono::steady_clock::time_point nextConnectAttempt;
+    std::chrono::milliseconds connectBackoff; // Before the attempt after next, doubling every attempt
+    unsigned int connectAttempts;
+    
+    PartyCache parties; // Everyone's, including our own
+    std::vector<uint64_t> wantedParties; // Hashes to ask for, reused
+    std::vector<sf::Packet> partyMessages; // Parties asked for, reused
+    
+    std::mutex inboxMutex;
+    std::vector<NetworkMessage> inbox; // Decoded by the event loop, waiting for ProcessMessages
+    std::atomic<bool> inboxWaiting; // Whether inbox has anything, so ProcessMessages can skip locking when it doesn't
+    std::vector<NetworkMessage> decoded; // The event loop's, decoded from a batch before it's queued in inbox
+    std::vector<NetworkMessage> messages; // Taken from the inbox by ProcessMessages
+    
     bool SetupSocket(unsigned short port);
+    sf::Socket::Status Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port);
+    
+    void StartReceiving();
+    void ReceiveMessages();
+    void HandleMessage(NetworkMessage& message, int peer);
+    void ResolveParty(NetworkGameState& gameState);
+    void RequestParties(sf::IpAddress const& address, unsigned short port);
+    void SendParties(const std::vector<uint64_t>& hashes, sf::IpAddress const& address, unsigned short port);
+    void ReceiveParties(std::vector<Party> const& received);
+    void MeasureLink(NetworkMessage const& message, int peer);
     
-    HostGameState HostUpdate(const NetworkGameState& localGameState);
-    void HandleConnectRequest(sf::Packet packet, sf::IpAddress sender, unsigned short port);
-    NetworkGameState HandleGameStateResponse(sf::Packet gameStatePacket, sf::IpAddress sender, unsigned short port);
+    HostGameState HostUpdate(const GameStateView& localGameState);
+    void HandleConnectRequest(const ConnectRequest& request, sf::IpAddress sender, unsigned short port);
+    void HandleGameState(NetworkMessage& message, int peer);
+    void EvictSilentClients(std::chrono::steady_clock::time_point now);
     
-    HostGameState ClientUpdate(const NetworkGameState& localGameState);
-    void HandleConnectResponse(sf::Packet gameStatePacket, sf::IpAddress sender, unsigned short port);
+    HostGameState ClientUpdate(const GameStateView& localGameState);
+    void HandleConnectResponse(const ConnectResponse& response);
+    void LoseHost();
+    void StartConnecting();
+    void SendConnectRequest(std::chrono::steady_clock::time_point now);
+    void RetryConnect(std::chrono::steady_clock::time_point now);
     void HandlePendingRequests();
     
-    void HandleGenericRequestPacket(sf::Packet& packet, sf::IpAddress sender, unsigned short port);
+    void HandleGenericRequest(const GenericRequestResponse& genericRequestResponse, sf::IpAddress sender, unsigned short port);
     void RemovePendingRequest(ResponseType responseType, int remotePlayerId);
     int FindClientUniqueId(sf::IpAddress sender, unsigned short port);
+    
+    EventLoop eventLoop; // Last, so it stops before anything it uses is destroyed
 };
 
 #endif //GAMEBOYEMULATOR_NETWORK_HPP
@@ -0,0 +1,125 @@
+//
+// Created by Austin on 10/19/2026.
+//
+// Times a host's network tick over loopback, draining one game state from every client and sending one packet back to
+// all of them, with and without batched datagram I/O:
+//
+//   NetworkBenchmark [-ticks=N] [-no-batching]
+//
+// Exits with 1 if the host's receive buffer couldn't hold every client's game state, as those ticks time less than a
+// whole tick's work.
+//
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DatagramTransport.hpp"
+
+namespace {
+    std::size_t const kGameStateSize = 600; // About what a player's game state with a full party takes
+    std::size_t const kHostGameStateSize = 1200; // What the host sends back, kept under one MTU
+}
+
+struct TickTimes {
+    double receive = 0; // Microseconds per tick
+    double send = 0;
+    double received = 0; // Datagrams per tick, fewer than the clients if the receive buffer overflowed
+};
+
+/**
+ * Runs the host's tick the given number of times with the number of clients, returning the average time taken to
+ * receive from and send to all of them.
+ */
+TickTimes TimeTicks(std::size_t numberOfClients, int ticks, bool batched) {
+    DatagramTransport host;
+    host.Bind(0);
+    host.SetBlocking(false);
+    host.batched = batched;
+    sf::IpAddress localhost(127, 0, 0, 1);
+
+    std::vector<std::unique_ptr<DatagramTransport>> clients;
+    std::vector<DatagramEndpoint> endpoints;
+    for (std::size_t index = 0; index < numberOfClients; ++index) {
+        clients.emplace_back(new DatagramTransport());
+        clients.back()->Bind(0);
+        clients.back()->SetBlocking(false);
+        endpoints.push_back({localhost, clients.back()->LocalPort()});
+    }
+
+    std::vector<char> data(kHostGameStateSize, 0x5A);
+    sf::Packet gameState;
+    gameState.append(data.data(), kGameStateSize);
+    sf::Packet hostGameState;
+    hostGameState.append(data.data(), kHostGameStateSize);
+    std::vector<ReceivedDatagram> received;
+    std::vector<ReceivedDatagram> clientReceived;
+
+    TickTimes times;
+    for (int tick = 0; tick < ticks; ++tick) {
+        // Loopback delivers as it sends, so every game state is waiting by the time the host's tick starts
+        for (auto& client : clients) {
+            client->Send(gameState, localhost, host.LocalPort());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto count = host.ReceiveBatch(received);
+        auto receivedAt = std::chrono::steady_clock::now();
+        host.SendToAll(hostGameState, endpoints);
+        auto end = std::chrono::steady_clock::now();
+
+        times.receive += std::chrono::duration<double, std::micro>(receivedAt - start).count();
+        times.send += std::chrono::duration<double, std::micro>(end - receivedAt).count();
+        times.received += count;
+
+        for (auto& client : clients) {
+            client->ReceiveBatch(clientReceived);
+        }
+    }
+    times.receive /= ticks;
+    times.send /= ticks;
+    times.received /= ticks;
+    return times;
+}
+
+/**
+ * Prints the times, and returns false (warning that they're for less than a whole tick) if any game states were dropped.
+ */
+bool PrintResult(std::size_t numberOfClients, bool batched, TickTimes const& times) {
+    std::cout << std::setw(4) << numberOfClients << " clients, " << (batched ? "batched    " : "one by one ")
+              << std::fixed << std::setprecision(1)
+              << "Receive: " << std::setw(8) << times.receive << " us (" << std::setw(5) << times.received << " datagrams)"
+              << "\tSend: " << std::setw(8) << times.send << " us"
+              << "\tTotal: " << std::setw(8) << times.receive + times.send << " us/tick" << std::endl;
+    if (times.received < numberOfClients) {
+        std::cout << "    Warning: the host's receive buffer overflowed, dropping " << numberOfClients - times.received
+                  << " of " << numberOfClients << " game states a tick, so these ticks did less than a full one's work"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int ticks = 1000;
+    bool batching = true;
+    for (int argument = 1; argument < argc; ++argument) {
+        auto arg = std::string(argv[argument]);
+        if (arg.find("-ticks=") == 0) {
+            ticks = std::stoi(arg.substr(7));
+        } else if (arg == "-no-batching") {
+            batching = false;
+        }
+    }
+
+    bool complete = true;
+    for (std::size_t numberOfClients : {8, 64, 256}) {
+        if (batching) {
+            complete = PrintResult(numberOfClients, true, TimeTicks(numberOfClients, ticks, true)) and complete;
+        }
+        complete = PrintResult(numberOfClients, false, TimeTicks(numberOfClients, ticks, false)) and complete;
+    }
+    return complete ? 0 : 1;
+}
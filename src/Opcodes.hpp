@@ -0,0 +1,155 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_OPCODES_HPP
+#define GAMEBOYEMULATOR_OPCODES_HPP
+
+#include <stdint.h>
+
+// Flags in F
+constexpr uint8_t kFlagZ = 0x80;
+constexpr uint8_t kFlagN = 0x40;
+constexpr uint8_t kFlagH = 0x20;
+constexpr uint8_t kFlagC = 0x10;
+constexpr uint8_t kFlagsAll = 0xF0;
+
+/**
+ * What an instruction looks like to anything that decodes code without running it (the predecoder and the idle loop
+ * detector), and the cycles the generated handlers take. Cycle counts are what Processor charges, which for jumps
+ * isn't always what the hardware takes.
+ */
+struct OpcodeInfo {
+    uint8_t length;       // Bytes, counting the 0xCB prefix for CB opcodes, or 0 if the opcode doesn't exist
+    uint8_t cycles;       // Clocks/4, or for a conditional jump, call or return, when it isn't taken
+    uint8_t takenCycles;  // Extra clocks/4 a conditional jump, call or return takes when taken
+    uint8_t flagsRead;    // Flags the result depends on
+    uint8_t flagsWritten; // Flags set, cleared or computed
+    bool endsBlock;       // Jumps, calls, returns, resets, HALT and STOP, after which the next instruction isn't the one that follows
+};
+
+struct OpcodeTable {
+    OpcodeInfo opcodes[256];
+
+    constexpr OpcodeInfo const& operator[](uint8_t opcode) const {return opcodes[opcode];}
+};
+
+/**
+ * Builds the main opcode's entry from its encoding. Most of the map is regular in its low three bits (the register,
+ * where 6 is (HL)) and the bits above them (the operation or destination register).
+ */
+constexpr OpcodeInfo MainOpcodeInfo(uint8_t opcode) {
+    uint8_t operand = opcode & 0x07;
+    uint8_t row = (opcode >> 3) & 0x07;
+
+    if (opcode == 0x76) return {1, 1, 0, 0, 0, true}; // HALT
+    if (opcode >= 0x40 and opcode < 0x80) {
+        // LD r,r'
+        return {1, static_cast<uint8_t>(operand == 6 or row == 6 ? 2 : 1), 0, 0, 0, false};
+    }
+    if (opcode >= 0x80 and opcode < 0xC0) {
+        // ADD, ADC, SUB, SBC, AND, XOR, OR and CP with A
+        uint8_t reads_carry = (row == 1 or row == 3) ? kFlagC : 0;
+        return {1, static_cast<uint8_t>(operand == 6 ? 2 : 1), 0, reads_carry, kFlagsAll, false};
+    }
+    if (opcode < 0x40) {
+        switch (opcode & 0x0F) {
+            case 0x01: return {3, 3, 0, 0, 0, false};                    // LD rr,nn
+            case 0x02: case 0x0A: return {1, 2, 0, 0, 0, false};         // LD (rr),A and LD A,(rr)
+            case 0x03: case 0x0B: return {1, 2, 0, 0, 0, false};         // INC rr and DEC rr
+            case 0x09: return {1, 2, 0, 0, kFlagN | kFlagH | kFlagC, false}; // ADD HL,rr
+            default: break;
+        }
+        switch (operand) {
+            case 4: case 5: // INC r and DEC r
+                return {1, static_cast<uint8_t>(row == 6 ? 3 : 1), 0, 0, kFlagZ | kFlagN | kFlagH, false};
+            case 6: // LD r,n
+                return {2, static_cast<uint8_t>(row == 6 ? 3 : 2), 0, 0, 0, false};
+            default: break;
+        }
+        switch (opcode) {
+            case 0x00: return {1, 1, 0, 0, 0, false};                                   // NOP
+            case 0x07: case 0x0F: return {1, 1, 0, 0, kFlagsAll, false};                // RLCA, RRCA
+            case 0x17: case 0x1F: return {1, 1, 0, kFlagC, kFlagsAll, false};           // RLA, RRA
+            case 0x08: return {3, 5, 0, 0, 0, false};                                   // LD (nn),SP
+            case 0x10: return {1, 0, 0, 0, 0, true};                                    // STOP
+            case 0x18: return {2, 4, 0, 0, 0, true};                                    // JR n
+            case 0x20: case 0x28: return {2, 3, 1, kFlagZ, 0, true};                    // JR NZ/Z,n
+            case 0x30: case 0x38: return {2, 3, 1, kFlagC, 0, true};                    // JR NC/C,n
+            case 0x27: return {1, 1, 0, kFlagN | kFlagH | kFlagC, kFlagZ | kFlagH | kFlagC, false}; // DAA
+            case 0x2F: return {1, 1, 0, 0, kFlagN | kFlagH, false};                     // CPL
+            case 0x37: return {1, 1, 0, 0, kFlagN | kFlagH | kFlagC, false};            // SCF
+            case 0x3F: return {1, 1, 0, kFlagC, kFlagN | kFlagH | kFlagC, false};       // CCF
+            default: return {0, 0, 0, 0, 0, false};
+        }
+    }
+
+    // C0-FF
+    uint8_t condition = (row & 0x02) ? kFlagC : kFlagZ; // NZ, Z, NC, C
+    switch (opcode) {
+        case 0xC0: case 0xC8: case 0xD0: case 0xD8: return {1, 2, 3, condition, 0, true}; // RET cc
+        case 0xC2: case 0xCA: case 0xD2: case 0xDA: return {3, 3, 1, condition, 0, true}; // JP cc,nn
+        case 0xC4: case 0xCC: case 0xD4: case 0xDC: return {3, 3, 3, condition, 0, true}; // CALL cc,nn
+        case 0xC1: case 0xD1: case 0xE1: return {1, 3, 0, 0, 0, false};                   // POP rr
+        case 0xF1: return {1, 3, 0, 0, kFlagsAll, false};                                 // POP AF
+        case 0xC5: case 0xD5: case 0xE5: return {1, 4, 0, 0, 0, false};                   // PUSH rr
+        case 0xF5: return {1, 4, 0, kFlagsAll, 0, false};                                 // PUSH AF
+        case 0xCE: case 0xDE: return {2, 2, 0, kFlagC, kFlagsAll, false};                 // ADC n, SBC n
+        case 0xC6: case 0xD6: case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+            return {2, 2, 0, 0, kFlagsAll, false};                                        // ADD, SUB, AND, XOR, OR, CP n
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF: case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+            return {1, 4, 0, 0, 0, true};                                                 // RST
+        case 0xC3: return {3, 4, 0, 0, 0, true};                                          // JP nn
+        case 0xC9: case 0xD9: return {1, 4, 0, 0, 0, true};                               // RET, RETI
+        case 0xCB: return {2, 0, 0, 0, 0, false};                                         // CB prefix, see kCbOpcodes
+        case 0xCD: return {3, 5, 0, 0, 0, true};                                          // CALL nn
+        case 0xE0: return {2, 3, 0, 0, 0, false};                                         // LDH (n),A
+        case 0xF0: return {2, 3, 0, 0, 0, false};                                         // LDH A,(n)
+        case 0xE2: case 0xF2: return {1, 2, 0, 0, 0, false};                              // LD (C),A and LD A,(C)
+        case 0xE8: return {2, 4, 0, 0, kFlagsAll, false};                                 // ADD SP,n
+        case 0xF8: return {2, 3, 0, 0, kFlagsAll, false};                                 // LD HL,SP+n
+        case 0xE9: return {1, 1, 0, 0, 0, true};                                          // JP (HL)
+        case 0xF9: return {1, 2, 0, 0, 0, false};                                         // LD SP,HL
+        case 0xEA: case 0xFA: return {3, 4, 0, 0, 0, false};                              // LD (nn),A and LD A,(nn)
+        case 0xF3: case 0xFB: return {1, 1, 0, 0, 0, false};                              // DI, EI
+        default: return {0, 0, 0, 0, 0, false};
+    }
+}
+
+/**
+ * Builds the entry for the opcode following 0xCB: rotates and shifts (00-3F), BIT (40-7F), RES (80-BF) and SET (C0-FF)
+ * of the register in the low three bits.
+ */
+constexpr OpcodeInfo CbOpcodeInfo(uint8_t opcode) {
+    bool memory = (opcode & 0x07) == 6;
+    if (opcode < 0x40) {
+        // RL and RR rotate through the carry
+        uint8_t reads_carry = (opcode >= 0x10 and opcode < 0x20) ? kFlagC : 0;
+        return {2, static_cast<uint8_t>(memory ? 4 : 2), 0, reads_carry, kFlagsAll, false};
+    }
+    if (opcode < 0x80) {
+        return {2, static_cast<uint8_t>(memory ? 3 : 2), 0, 0, kFlagZ | kFlagN | kFlagH, false};
+    }
+    return {2, static_cast<uint8_t>(memory ? 4 : 2), 0, 0, 0, false};
+}
+
+constexpr OpcodeTable MakeMainOpcodeTable() {
+    OpcodeTable table{};
+    for (unsigned int opcode = 0; opcode < 256; ++opcode) {
+        table.opcodes[opcode] = MainOpcodeInfo(static_cast<uint8_t>(opcode));
+    }
+    return table;
+}
+
+constexpr OpcodeTable MakeCbOpcodeTable() {
+    OpcodeTable table{};
+    for (unsigned int opcode = 0; opcode < 256; ++opcode) {
+        table.opcodes[opcode] = CbOpcodeInfo(static_cast<uint8_t>(opcode));
+    }
+    return table;
+}
+
+constexpr OpcodeTable kOpcodes = MakeMainOpcodeTable();
+constexpr OpcodeTable kCbOpcodes = MakeCbOpcodeTable();
+
+#endif //GAMEBOYEMULATOR_OPCODES_HPP
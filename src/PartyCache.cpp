@@ -0,0 +1,43 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "PartyCache.hpp"
+
+#include <algorithm>
+
+std::size_t const PartyCache::kMaxParties;
+
+/**
+ * 64-bit FNV-1a, which is plenty to tell a few hundred parties apart and takes under a microsecond for one.
+ */
+uint64_t PartyCache::Hash(uint8_t const* party) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (std::size_t index = 0; index < std::tuple_size<Party>::value; ++index) {
+        hash = (hash ^ party[index]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+/**
+ * Returns the party with the hash, or null if it isn't cached.
+ */
+Party const* PartyCache::Find(uint64_t hash) const {
+    auto party = parties.find(hash);
+    return party != parties.end() ? &party->second : nullptr;
+}
+
+/**
+ * Caches the party (0x194 bytes) if it isn't already, returning its hash.
+ */
+uint64_t PartyCache::Insert(uint8_t const* party) {
+    auto hash = Hash(party);
+    if (parties.count(hash)) return hash;
+
+    if (parties.size() >= kMaxParties) {
+        // Rather than tracking which are still used, forget them all; those still used are asked for again
+        parties.clear();
+    }
+    std::copy_n(party, std::tuple_size<Party>::value, parties[hash].begin());
+    return hash;
+}
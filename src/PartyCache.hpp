@@ -0,0 +1,36 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_PARTYCACHE_HPP
+#define GAMEBOYEMULATOR_PARTYCACHE_HPP
+
+#include <stdint.h>
+#include <array>
+#include <unordered_map>
+
+/**
+ * A player's pokemon party as it is in WRAM, from 0xd163 to 0xd2f6.
+ */
+typedef std::array<uint8_t, 0x194> Party;
+
+/**
+ * Parties kept by their hash, so players can send the hash of their party with every game state and the party itself
+ * only to whoever asks for a hash they don't have (see PARTY_REQUEST). Parties only change after battles, catches and
+ * menu swaps, so once everyone's are cached nothing more is sent until one does.
+ */
+class PartyCache {
+public:
+    static std::size_t const kMaxParties = 1024; // About 400KB, cleared when full and filled again by asking
+
+    static uint64_t Hash(uint8_t const* party);
+
+    Party const* Find(uint64_t hash) const;
+    uint64_t Insert(uint8_t const* party);
+    std::size_t Size() const {return parties.size();}
+
+private:
+    std::unordered_map<uint64_t, Party> parties; // Hash, Party
+};
+
+#endif //GAMEBOYEMULATOR_PARTYCACHE_HPP
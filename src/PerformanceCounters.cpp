@@ -0,0 +1,80 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "PerformanceCounters.hpp"
+
+namespace {
+    std::array<char const*, PerformanceCounters::kRegions> const kRegionNames = {{
+        "rom0", "romx", "vram", "eram", "wram", "echo", "oam", "io_hram"
+    }};
+
+    std::array<char const*, PerformanceCounters::kInterrupts> const kInterruptNames = {{
+        "vblank", "stat", "timer", "serial", "joypad"
+    }};
+}
+
+char const* PerformanceCounters::RegionName(MemoryRegion region) {
+    return kRegionNames[static_cast<std::size_t>(region)];
+}
+
+char const* PerformanceCounters::InterruptName(std::size_t interrupt) {
+    return kInterruptNames[interrupt];
+}
+
+uint64_t PerformanceCounters::Reads() const {
+    uint64_t total = 0;
+    for (auto count : reads) total += count;
+    return total;
+}
+
+uint64_t PerformanceCounters::Writes() const {
+    uint64_t total = 0;
+    for (auto count : writes) total += count;
+    return total;
+}
+
+PerformanceCounters& PerformanceCounters::operator +=(PerformanceCounters const& counters) {
+    instructions += counters.instructions;
+    cbInstructions += counters.cbInstructions;
+    haltedCycles += counters.haltedCycles;
+    idleCycles += counters.idleCycles;
+    for (std::size_t region = 0; region < kRegions; ++region) {
+        reads[region] += counters.reads[region];
+        writes[region] += counters.writes[region];
+    }
+    hookHits += counters.hookHits;
+    for (std::size_t interrupt = 0; interrupt < kInterrupts; ++interrupt) {
+        interrupts[interrupt] += counters.interrupts[interrupt];
+    }
+    scanlines += counters.scanlines;
+    oamDmas += counters.oamDmas;
+    networkBytesIn += counters.networkBytesIn;
+    networkBytesOut += counters.networkBytesOut;
+    networkMessages += counters.networkMessages;
+    networkMessageWait += counters.networkMessageWait;
+    networkTime += counters.networkTime;
+    return *this;
+}
+
+/**
+ * Writes the column names matching WriteCsvRow.
+ */
+void PerformanceCounters::WriteCsvHeader(std::ostream& output) {
+    output << "frame,instructions,cb_instructions,halted_cycles,idle_cycles";
+    for (auto name : kRegionNames) output << ",reads_" << name;
+    for (auto name : kRegionNames) output << ",writes_" << name;
+    output << ",hook_hits";
+    for (auto name : kInterruptNames) output << ",interrupts_" << name;
+    output << ",scanlines,oam_dmas,network_bytes_in,network_bytes_out,network_messages,network_message_wait_ns,network_time_ns\n";
+}
+
+void PerformanceCounters::WriteCsvRow(std::ostream& output, uint64_t frame) const {
+    output << frame << ',' << instructions << ',' << cbInstructions << ',' << haltedCycles << ',' << idleCycles;
+    for (auto count : reads) output << ',' << count;
+    for (auto count : writes) output << ',' << count;
+    output << ',' << hookHits;
+    for (auto count : interrupts) output << ',' << count;
+    output << ',' << scanlines << ',' << oamDmas << ',' << networkBytesIn << ',' << networkBytesOut
+           << ',' << networkMessages << ',' << networkMessageWait << ',' << networkTime << '\n';
+}
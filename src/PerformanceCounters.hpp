@@ -0,0 +1,82 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_PERFORMANCECOUNTERS_HPP
+#define GAMEBOYEMULATOR_PERFORMANCECOUNTERS_HPP
+
+#include <stdint.h>
+#include <array>
+#include <ostream>
+
+/**
+ * Areas of the memory map that reads and writes are counted by.
+ */
+enum class MemoryRegion {
+    ROM0,    // 0000-3FFF
+    ROMX,    // 4000-7FFF, switchable bank
+    VRAM,    // 8000-9FFF
+    ERAM,    // A000-BFFF, cartridge RAM
+    WRAM,    // C000-DFFF
+    ECHO,    // E000-FDFF
+    OAM,     // FE00-FEFF
+    IO_HRAM, // FF00-FFFF, I/O registers, HRAM and IE
+    COUNT
+};
+
+/**
+ * Counts of what the emulated hardware did, like a CPU's performance counters. GameBoy keeps one set for the frame
+ * being run, one for the last finished frame and one for everything since power on.
+ *
+ * Every count is a plain increment on a pointer the components were given at Initialize, so they're always on.
+ */
+struct PerformanceCounters {
+    static std::size_t const kRegions = static_cast<std::size_t>(MemoryRegion::COUNT);
+    static std::size_t const kInterrupts = 5; // V-Blank, LCD STAT, Timer, Serial, Joypad
+
+    uint64_t instructions = 0;
+    uint64_t cbInstructions = 0; // Included in instructions
+    uint64_t haltedCycles = 0;   // Clocks/4 spent halted rather than executing
+    uint64_t idleCycles = 0;     // Clocks/4 of idle loops skipped rather than executed (their instructions still count)
+    std::array<uint64_t, kRegions> reads{};
+    std::array<uint64_t, kRegions> writes{};
+    uint64_t hookHits = 0;       // Reads and writes a battle hook overrode
+    std::array<uint64_t, kInterrupts> interrupts{};
+    uint64_t scanlines = 0;
+    uint64_t oamDmas = 0;
+    uint64_t networkBytesIn = 0;
+    uint64_t networkBytesOut = 0;
+    uint64_t networkMessages = 0;    // Packets handled, counted when handled rather than when they arrived
+    uint64_t networkMessageWait = 0; // Nanoseconds those packets waited between arriving and being handled
+    uint64_t networkTime = 0;        // Nanoseconds spent handling packets and exchanging game states
+
+    static MemoryRegion RegionOf(uint16_t address);
+    static char const* RegionName(MemoryRegion region);
+    static char const* InterruptName(std::size_t interrupt);
+
+    void CountRead(uint16_t address) {++reads[static_cast<std::size_t>(RegionOf(address))];}
+    void CountWrite(uint16_t address) {++writes[static_cast<std::size_t>(RegionOf(address))];}
+
+    uint64_t Reads() const;
+    uint64_t Writes() const;
+    PerformanceCounters& operator +=(PerformanceCounters const& counters);
+
+    static void WriteCsvHeader(std::ostream& output);
+    void WriteCsvRow(std::ostream& output, uint64_t frame) const;
+};
+
+/**
+ * Every region but the last page is a whole number of 4KB pages, so most addresses are looked up by their top nibble.
+ */
+inline MemoryRegion PerformanceCounters::RegionOf(uint16_t address) {
+    static std::array<MemoryRegion, 16> const kPageRegions = {{
+        MemoryRegion::ROM0, MemoryRegion::ROM0, MemoryRegion::ROM0, MemoryRegion::ROM0,
+        MemoryRegion::ROMX, MemoryRegion::ROMX, MemoryRegion::ROMX, MemoryRegion::ROMX,
+        MemoryRegion::VRAM, MemoryRegion::VRAM, MemoryRegion::ERAM, MemoryRegion::ERAM,
+        MemoryRegion::WRAM, MemoryRegion::WRAM, MemoryRegion::ECHO, MemoryRegion::ECHO
+    }};
+    if (address < 0xFE00) return kPageRegions[address >> 12];
+    return address < 0xFF00 ? MemoryRegion::OAM : MemoryRegion::IO_HRAM;
+}
+
+#endif //GAMEBOYEMULATOR_PERFORMANCECOUNTERS_HPP
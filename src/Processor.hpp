@@ -6,11 +6,13 @@
 #define GAMEBOYEMULATOR_PROCESSOR_HPP
 
 #include <inttypes.h>
+#include <array>
 #include <vector>
-#include <functional>
+#include <utility>
 
 class MemoryManagementUnit;
 class GameBoy;
+struct PerformanceCounters;
 
 /**
  * 16 bit register whose 8 bit contents (upper and lower) can be accessed individually
@@ -23,6 +25,24 @@ union Register {
     };
 };
 
+/**
+ * One predecoded instruction: its opcode and the immediate bytes that follow it (for 0xCB, the CB opcode).
+ */
+struct MicroOp {
+    uint16_t address;
+    uint8_t opcode;
+    uint8_t length; // Including the opcode
+    std::array<uint8_t, 2> immediates;
+};
+
+/**
+ * A straight run of predecoded instructions, ending at the first jump, call, return or halt.
+ */
+struct BasicBlock {
+    uint32_t first; // Index into Processor::microOps
+    uint32_t count; // 0 if the first instruction can't be predecoded
+};
+
 class Processor {
 friend class GameBoy;
 public:
@@ -37,103 +57,104 @@ public:
 	uint8_t interrupt_master_enable;
 	
 	uint8_t halt;
-	uint64_t frame_clock;
+	uint64_t frame_clock; // End of the cycle budget GameBoy::RunUntil is running to
 	uint64_t clock; // Tracks totally clocks/4 passed
 	uint8_t m_clock; // Tracks cycles/4 passed for an instruction
+	
+	bool predecode; // Run ROM code from predecoded blocks instead of fetching each byte through the MMU
+	
+	// Set by a taken JP or JR back to itself or an earlier address, for IdleLoopDetector (which clears it)
+	bool jumpedBack;
+	uint16_t jumpAddress; // Address of that JP or JR
 
     Processor();
 
-    void Initialize(MemoryManagementUnit* mmu_);
+    void Initialize(MemoryManagementUnit* mmu_, PerformanceCounters* counters_);
     void Reset();
     void ExecuteNextInstruction();
 	void ExecuteOpcode(uint8_t opcode);
+	void ClearBlockCache();
+	void ResolveFlags();
 
 
 private:
     MemoryManagementUnit* mmu;
+    PerformanceCounters* counters;
 	
 	void InterruptReturn();
 	void InterruptStore();
 	
-	std::vector<std::function<void()>> opcode_map;
-	std::vector<std::function<void()>> cb_opcode_map;
+	// Instructions on an 8 bit operand pick it by a three bit field of the opcode, where 6 is the memory at HL
+	enum Operand : uint8_t {B, C, D, E, H, L, HL_MEMORY, A};
+	// Bits 3-5 of CB 00-3F
+	enum Shift : uint8_t {RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL};
+	
+	typedef void (Processor::*Instruction)();
+	std::array<Instruction, 256> opcode_map;
+	std::array<Instruction, 256> cb_opcode_map;
+	
+	template <std::size_t... opcodes>
+	static std::array<Instruction, 256> CbInstructionTable(std::index_sequence<opcodes...>);
+	template <uint8_t opcode> void CbInstruction();
+	
+	uint8_t& Register8(uint8_t operand);
+	template <uint8_t operand> uint8_t ReadOperand();
+	template <uint8_t operand> void WriteOperand(uint8_t value);
+	
+	// Predecoded ROM code. Blocks are found by ROM page (0 for 0000-3FFF, 1 + bank for 4000-7FFF) and the address's
+	// offset in it, where each page's table is only allocated once code in it first runs.
+	static uint32_t const kMaxBlockLength = 64;
+	std::vector<MicroOp> microOps;
+	std::vector<BasicBlock> blocks;
+	std::vector<std::vector<uint32_t>> blockPages; // Block index + 1 starting at each offset, 0 if not decoded yet
+	std::size_t nextMicroOp;
+	std::size_t blockEnd;
+	unsigned int blockPage;
+	uint8_t const* immediates; // Current instruction's predecoded immediates, nullptr when fetching through the MMU
+	uint16_t immediateAddress;
+	
+	MicroOp const* NextMicroOp();
+	uint32_t DecodeBlock(uint16_t address, unsigned int bank);
+	uint8_t ReadImmediate(uint16_t address);
+	uint16_t ReadImmediateWord(uint16_t address);
+	
+	// Lazily computed flags. The 8 bit arithmetic and logic instructions only record their operation, operands and
+	// result; the F register is worked out from them when something reads it (ResolveFlags), and conditional jumps only
+	// work out the flag they test. FlagOperation::NONE means AF.lower is up to date.
+	enum class FlagOperation : uint8_t {NONE, ADD, ADC, SUB, SBC, AND, OR, XOR, INC, DEC};
+	FlagOperation flagOperation;
+	uint8_t flagLeft;    // A (or the INC/DEC operand) before the operation
+	uint8_t flagRight;
+	uint8_t flagCarryIn; // Carry into ADC/SBC, or the carry INC/DEC leave as it was
+	uint8_t flagResult;
+	
+	void Jump(uint16_t target);
+	void JumpRelative(uint8_t offset);
+	
+	void RecordFlags(FlagOperation operation, uint8_t left, uint8_t right, uint8_t carry_in, uint8_t result);
+	bool ZeroFlag() const;
+	bool CarryFlag() const;
+	void Add(uint8_t value);
+	void AddWithCarry(uint8_t value);
+	void Subtract(uint8_t value);
+	void SubtractWithCarry(uint8_t value);
+	void Compare(uint8_t value);
+	void And(uint8_t value);
+	void Or(uint8_t value);
+	void Xor(uint8_t value);
+	uint8_t Increment(uint8_t value);
+	uint8_t Decrement(uint8_t value);
 	// Long list of opcodes
 	// TODO: Create unit tests for opcodes, where registers are loaded with values, opcode performed, 
 	//		 then tests are made to verify values in memory or registers or flags.
 	// TODO2: Just have all related instructions in a row instead of eaching have their own newline
 	/* Load Section */
-	// Load register from other register: register = register
-	void LDrr_bb();
-	void LDrr_bc();
-	void LDrr_bd();
-	void LDrr_be();
-	void LDrr_bh();
-	void LDrr_bl();
-	void LDrr_ba();
-	void LDrr_cb();
-	void LDrr_cc();
-	void LDrr_cd();
-	void LDrr_ce();
-	void LDrr_ch();
-	void LDrr_cl();
-	void LDrr_ca();
-	void LDrr_db();
-	void LDrr_dc();
-	void LDrr_dd();
-	void LDrr_de();
-	void LDrr_dh();
-	void LDrr_dl();
-	void LDrr_da();
-	void LDrr_eb();
-	void LDrr_ec();
-	void LDrr_ed();
-	void LDrr_ee();
-	void LDrr_eh();
-	void LDrr_el();
-	void LDrr_ea();
-	void LDrr_hb();
-	void LDrr_hc();
-	void LDrr_hd();
-	void LDrr_he();
-	void LDrr_hh();
-	void LDrr_hl();
-	void LDrr_ha();
-	void LDrr_lb();
-	void LDrr_lc();
-	void LDrr_ld();
-	void LDrr_le();
-	void LDrr_lh();
-	void LDrr_ll();
-	void LDrr_la();
-	void LDrr_ab();
-	void LDrr_ac();
-	void LDrr_ad();
-	void LDrr_ae();
-	void LDrr_ah();
-	void LDrr_al();
-	void LDrr_aa();
+	// Load register from register or memory at HL, or memory at HL from register: destination = source
+	template <uint8_t destination, uint8_t source> void LoadRegister();
 	
 	// Put Stack Pointer at address 
 	void LDmmSP();
 
-	// Load register from memory: register = *(HL)
-	void LDrHLm_b();
-	void LDrHLm_c();
-	void LDrHLm_d();
-	void LDrHLm_e();
-	void LDrHLm_h();
-	void LDrHLm_l();
-	void LDrHLm_a();
-
-	// Write memory from register: *(HL) = register
-	void LDHLmr_b();
-	void LDHLmr_c();
-	void LDHLmr_d();
-	void LDHLmr_e();
-	void LDHLmr_h();
-	void LDHLmr_l();
-	void LDHLmr_a();
-
 	// Load register with value: register = value (where value is at program counter)
 	void LDrn_b();
 	void LDrn_c();
@@ -177,16 +198,6 @@ private:
 	void LDHLSPn();
 	void LDSPHL();
 
-	// Swap upper and lower nibbles of register (affects zero flag)
-	void SWAPr_b();
-	void SWAPr_c();
-	void SWAPr_d();
-	void SWAPr_e();
-	void SWAPr_h();
-	void SWAPr_l();
-	void SWAPr_a();
-	void SWAPHLm();
-
 	// Data Manipulation
 	// Add to register or memory
 	void ADDr_b();
@@ -310,223 +321,10 @@ private:
 	void DECHL();
 	void DECSP();
 
-	// Bit manipulation
-	// Test if bit in register is set
-	void BIT0b();
-	void BIT0c();
-	void BIT0d();
-	void BIT0e();
-	void BIT0h();
-	void BIT0l();
-	void BIT0a();
-	void BIT0m();
-                
-	void RES0b();
-	void RES0c();
-	void RES0d();
-	void RES0e();
-	void RES0h();
-	void RES0l();
-	void RES0a();
-	void RES0m();
-	            
-	void SET0b();
-	void SET0c();
-	void SET0d();
-	void SET0e();
-	void SET0h();
-	void SET0l();
-	void SET0a();
-	void SET0m();
-                
-	void BIT1b();
-	void BIT1c();
-	void BIT1d();
-	void BIT1e();
-	void BIT1h();
-	void BIT1l();
-	void BIT1a();
-	void BIT1m();
-                
-	void RES1b();
-	void RES1c();
-	void RES1d();
-	void RES1e();
-	void RES1h();
-	void RES1l();
-	void RES1a();
-	void RES1m();
-                
-	void SET1b();
-	void SET1c();
-	void SET1d();
-	void SET1e();
-	void SET1h();
-	void SET1l();
-	void SET1a();
-	void SET1m();
-                
-	void BIT2b();
-	void BIT2c();
-	void BIT2d();
-	void BIT2e();
-	void BIT2h();
-	void BIT2l();
-	void BIT2a();
-	void BIT2m();
-                
-	void RES2b();
-	void RES2c();
-	void RES2d();
-	void RES2e();
-	void RES2h();
-	void RES2l();
-	void RES2a();
-	void RES2m();
-                
-	void SET2b();
-	void SET2c();
-	void SET2d();
-	void SET2e();
-	void SET2h();
-	void SET2l();
-	void SET2a();
-	void SET2m();
-                
-	void BIT3b();
-	void BIT3c();
-	void BIT3d();
-	void BIT3e();
-	void BIT3h();
-	void BIT3l();
-	void BIT3a();
-	void BIT3m();
-                
-	void RES3b();
-	void RES3c();
-	void RES3d();
-	void RES3e();
-	void RES3h();
-	void RES3l();
-	void RES3a();
-	void RES3m();
-                
-	void SET3b();
-	void SET3c();
-	void SET3d();
-	void SET3e();
-	void SET3h();
-	void SET3l();
-	void SET3a();
-	void SET3m();
-                
-	void BIT4b();
-	void BIT4c();
-	void BIT4d();
-	void BIT4e();
-	void BIT4h();
-	void BIT4l();
-	void BIT4a();
-	void BIT4m();
-                
-	void RES4b();
-	void RES4c();
-	void RES4d();
-	void RES4e();
-	void RES4h();
-	void RES4l();
-	void RES4a();
-	void RES4m();
-                
-	void SET4b();
-	void SET4c();
-	void SET4d();
-	void SET4e();
-	void SET4h();
-	void SET4l();
-	void SET4a();
-	void SET4m();
-                
-	void BIT5b();
-	void BIT5c();
-	void BIT5d();
-	void BIT5e();
-	void BIT5h();
-	void BIT5l();
-	void BIT5a();
-	void BIT5m();
-                
-	void RES5b();
-	void RES5c();
-	void RES5d();
-	void RES5e();
-	void RES5h();
-	void RES5l();
-	void RES5a();
-	void RES5m();
-                
-	void SET5b();
-	void SET5c();
-	void SET5d();
-	void SET5e();
-	void SET5h();
-	void SET5l();
-	void SET5a();
-	void SET5m();
-                
-	void BIT6b();
-	void BIT6c();
-	void BIT6d();
-	void BIT6e();
-	void BIT6h();
-	void BIT6l();
-	void BIT6a();
-	void BIT6m();
-                
-	void RES6b();
-	void RES6c();
-	void RES6d();
-	void RES6e();
-	void RES6h();
-	void RES6l();
-	void RES6a();
-	void RES6m();
-                
-	void SET6b();
-	void SET6c();
-	void SET6d();
-	void SET6e();
-	void SET6h();
-	void SET6l();
-	void SET6a();
-	void SET6m();
-                
-	void BIT7b();
-	void BIT7c();
-	void BIT7d();
-	void BIT7e();
-	void BIT7h();
-	void BIT7l();
-	void BIT7a();
-	void BIT7m();
-                
-	void RES7b();
-	void RES7c();
-	void RES7d();
-	void RES7e();
-	void RES7h();
-	void RES7l();
-	void RES7a();
-	void RES7m();
-                
-	void SET7b();
-	void SET7c();
-	void SET7d();
-	void SET7e();
-	void SET7h();
-	void SET7l();
-	void SET7a();
-	void SET7m();
+	// Bit manipulation (CB 40-FF): test, clear or set a bit of a register or memory at HL
+	template <uint8_t bit, uint8_t operand> void TestBit();
+	template <uint8_t bit, uint8_t operand> void ResetBit();
+	template <uint8_t bit, uint8_t operand> void SetBit();
 
 	// Rotate A register Note: Missing Zero flag?
 	void RLA();
@@ -534,78 +332,8 @@ private:
 	void RRA();
 	void RRCA();
 
-	// Rotate register left
-	void RLr_b();
-	void RLr_c();
-	void RLr_d();
-	void RLr_e();
-	void RLr_h();
-	void RLr_l();
-	void RLr_a();
-	void RLHL();
-
-	void RLCr_b();
-	void RLCr_c();
-	void RLCr_d();
-	void RLCr_e();
-	void RLCr_h();
-	void RLCr_l();
-	void RLCr_a();
-	void RLCHL();
-
-	// Rotate register right
-	void RRr_b();
-	void RRr_c();
-	void RRr_d();
-	void RRr_e();
-	void RRr_h();
-	void RRr_l();
-	void RRr_a();
-	void RRHL();
-
-	void RRCr_b();
-	void RRCr_c();
-	void RRCr_d();
-	void RRCr_e();
-	void RRCr_h();
-	void RRCr_l();
-	void RRCr_a();
-	void RRCHL();
-
-	void SLAr_b();
-	void SLAr_c();
-	void SLAr_d();
-	void SLAr_e();
-	void SLAr_h();
-	void SLAr_l();
-	void SLAr_a();
-	void SLAHLm();
-
-	//void SLLr_b
-	//void SLLr_c
-	//void SLLr_d
-	//void SLLr_e
-	//void SLLr_h
-	//void SLLr_l
-	//void SLLr_a
-
-	void SRAr_b();
-	void SRAr_c();
-	void SRAr_d();
-	void SRAr_e();
-	void SRAr_h();
-	void SRAr_l();
-	void SRAr_a();
-	void SRAHLm();
-                 
-	void SRLr_b();
-	void SRLr_c();
-	void SRLr_d();
-	void SRLr_e();
-	void SRLr_h();
-	void SRLr_l();
-	void SRLr_a();
-	void SRLHLm();
+	// Rotate, shift or swap the nibbles of a register or memory at HL (CB 00-3F)
+	template <uint8_t shift, uint8_t operand> void RotateOrShift();
 
 	// Note: This is a great example of where Nazar's code differs from the documentation. Instead of checking for zero, should just set N and H flags. Need to double check opcodes!!!
 	void CPL();
@@ -0,0 +1,246 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "Profiler.hpp"
+
+#ifdef POKESYNCH_PROFILER
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    struct ZoneInfo {
+        char const* name;
+        char const* shortName; // For the overlay, which only fits 20 characters a line
+        bool traced; // Zones called too often to trace every call are only written as per frame totals
+    };
+
+    std::array<ZoneInfo, static_cast<std::size_t>(ProfileZone::COUNT)> const kZones = {{
+        {"CPU loop",             "CPU", true},
+        {"Timer::Increment",     "TMR", false},
+        {"RenderScanline",       "SCN", true},
+        {"Display::RenderFrame", "LCD", true},
+        {"Network::Update",      "NET", true},
+        {"DisplayPlayers",       "PLY", true},
+        {"Present",              "PRS", true}
+    }};
+
+    double Milliseconds(std::chrono::nanoseconds time) {
+        return time.count() / 1e6;
+    }
+
+    double Microseconds(std::chrono::steady_clock::duration time) {
+        return std::chrono::duration<double, std::micro>(time).count();
+    }
+}
+
+thread_local Profiler* Profiler::current = nullptr;
+
+Profiler::Profiler()
+    : showOverlay(false)
+    , nextHistory(0)
+    , frameStarted(false)
+    , tracing(false) {
+}
+
+char const* Profiler::ZoneName(ProfileZone zone) {
+    return kZones[static_cast<std::size_t>(zone)].name;
+}
+
+/**
+ * Finishes the previous frame and binds this profiler to the calling thread for the new one.
+ */
+void Profiler::BeginFrame() {
+    current = this;
+    EndFrame();
+
+    frame = FrameProfile();
+    frameStart = std::chrono::steady_clock::now();
+    lastZoneEnd = frameStart;
+    frameStarted = true;
+}
+
+/**
+ * Adds one call of the zone to the current frame. Zones that finish between frames (presenting the last frame) count
+ * towards the frame they finish after.
+ */
+void Profiler::AddZone(ProfileZone zone, std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end) {
+    auto index = static_cast<std::size_t>(zone);
+    frame.zoneTime[index] += end - start;
+    ++frame.zoneCalls[index];
+    lastZoneEnd = std::max(lastZoneEnd, end);
+
+    if (tracing and kZones[index].traced and traceEvents.size() < kMaxTraceEvents) {
+        traceEvents.push_back({zone, Microseconds(start - traceStart), Microseconds(end - start)});
+    }
+}
+
+void Profiler::EndFrame() {
+    if (!frameStarted) return;
+    frame.frameTime = lastZoneEnd - frameStart;
+
+    if (history.size() < kHistoryLength) {
+        history.push_back(frame);
+    } else {
+        history[nextHistory] = frame;
+    }
+    nextHistory = (nextHistory + 1) % kHistoryLength;
+
+    if (tracing and traceEvents.size() < kMaxTraceEvents) {
+        traceFrames.push_back(frame);
+        traceFrameStarts.push_back(Microseconds(frameStart - traceStart));
+    }
+}
+
+/**
+ * Starts recording a trace of every call of the traced zones (and per frame totals of the rest).
+ */
+void Profiler::StartTrace() {
+    tracing = true;
+    traceStart = std::chrono::steady_clock::now();
+    traceEvents.clear();
+    traceFrames.clear();
+    traceFrameStarts.clear();
+}
+
+/**
+ * Writes the trace in Chrome's trace event format, to be opened in chrome://tracing or Perfetto.
+ */
+bool Profiler::WriteTrace(std::string const& file_name) {
+    std::ofstream output(file_name);
+    if (!output) return false;
+
+    output << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() -> char const* {
+        char const* text = first ? "" : ",\n";
+        first = false;
+        return text;
+    };
+
+    for (std::size_t index = 0; index < traceFrames.size(); ++index) {
+        auto const& frameProfile = traceFrames[index];
+        output << separator() << "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+               << traceFrameStarts[index] << ",\"dur\":" << Microseconds(frameProfile.frameTime) << "}";
+
+        for (std::size_t zone = 0; zone < kZones.size(); ++zone) {
+            if (kZones[zone].traced) continue;
+            output << separator() << "{\"name\":\"" << kZones[zone].name << "\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":"
+                   << traceFrameStarts[index] << ",\"args\":{\"ms\":" << Milliseconds(frameProfile.zoneTime[zone])
+                   << ",\"calls\":" << frameProfile.zoneCalls[zone] << "}}";
+        }
+    }
+    for (auto const& event : traceEvents) {
+        output << separator() << "{\"name\":\"" << ZoneName(event.zone) << "\",\"cat\":\"emulator\",\"ph\":\"X\","
+               << "\"pid\":1,\"tid\":1,\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+    }
+
+    output << "\n]}" << std::endl;
+    return static_cast<bool>(output);
+}
+
+/**
+ * Returns the average of each timing over the recent frames.
+ */
+FrameProfile Profiler::Average() const {
+    FrameProfile average;
+    if (history.empty()) return average;
+
+    std::array<uint64_t, static_cast<std::size_t>(ProfileZone::COUNT)> calls{};
+    for (auto const& frameProfile : history) {
+        average.frameTime += frameProfile.frameTime;
+        for (std::size_t zone = 0; zone < kZones.size(); ++zone) {
+            average.zoneTime[zone] += frameProfile.zoneTime[zone];
+            calls[zone] += frameProfile.zoneCalls[zone];
+        }
+    }
+
+    average.frameTime /= history.size();
+    for (std::size_t zone = 0; zone < kZones.size(); ++zone) {
+        average.zoneTime[zone] /= history.size();
+        average.zoneCalls[zone] = static_cast<uint32_t>(calls[zone] / history.size());
+    }
+    return average;
+}
+
+/**
+ * Returns the frame time that the given fraction (0 to 1) of recent frames finished within.
+ */
+std::chrono::nanoseconds Profiler::FrameTimePercentile(double percentile) const {
+    if (history.empty()) return std::chrono::nanoseconds(0);
+
+    std::vector<std::chrono::nanoseconds> frameTimes;
+    for (auto const& frameProfile : history) {
+        frameTimes.push_back(frameProfile.frameTime);
+    }
+    auto index = std::min(static_cast<std::size_t>(percentile * frameTimes.size()), frameTimes.size() - 1);
+    std::nth_element(frameTimes.begin(), frameTimes.begin() + index, frameTimes.end());
+    return frameTimes[index];
+}
+
+/**
+ * Returns how many recent frames fell in each bucketWidth wide bucket of frame time. The last bucket also counts
+ * every frame longer than it.
+ */
+std::vector<unsigned int> Profiler::FrameTimeHistogram(std::chrono::nanoseconds bucketWidth, std::size_t buckets) const {
+    std::vector<unsigned int> histogram(buckets, 0);
+    for (auto const& frameProfile : history) {
+        auto bucket = static_cast<std::size_t>(frameProfile.frameTime / bucketWidth);
+        ++histogram[std::min(bucket, buckets - 1)];
+    }
+    return histogram;
+}
+
+/**
+ * Returns the overlay's text, in milliseconds averaged over recent frames.
+ */
+std::vector<std::string> Profiler::OverlayLines() const {
+    auto average = Average();
+    auto zoneTime = [&](ProfileZone zone) {
+        std::ostringstream text;
+        text << kZones[static_cast<std::size_t>(zone)].shortName << " " << std::fixed << std::setprecision(2)
+             << Milliseconds(average.zoneTime[static_cast<std::size_t>(zone)]);
+        return text.str();
+    };
+
+    std::ostringstream frameLine;
+    frameLine << std::fixed << std::setprecision(1) << "FRM " << Milliseconds(average.frameTime)
+              << " P99 " << Milliseconds(FrameTimePercentile(0.99));
+    return {frameLine.str(),
+            zoneTime(ProfileZone::CPU) + " " + zoneTime(ProfileZone::TIMER),
+            zoneTime(ProfileZone::SCANLINE) + " " + zoneTime(ProfileZone::DISPLAY_FRAME),
+            zoneTime(ProfileZone::NETWORK) + " " + zoneTime(ProfileZone::DISPLAY_PLAYERS),
+            zoneTime(ProfileZone::PRESENT)};
+}
+
+/**
+ * Prints frame time percentiles, a histogram of frame times and each zone's average over the recent frames.
+ */
+void Profiler::Report(std::ostream& output) const {
+    auto average = Average();
+    output << std::fixed << std::setprecision(3)
+           << "Frame time over the last " << history.size() << " frames: " << Milliseconds(average.frameTime)
+           << "ms average, " << Milliseconds(FrameTimePercentile(0.5)) << "ms p50, "
+           << Milliseconds(FrameTimePercentile(0.95)) << "ms p95, " << Milliseconds(FrameTimePercentile(0.99))
+           << "ms p99" << std::endl;
+
+    auto histogram = FrameTimeHistogram(std::chrono::milliseconds(1), 20);
+    for (std::size_t bucket = 0; bucket < histogram.size(); ++bucket) {
+        if (histogram[bucket] == 0) continue;
+        output << "  " << std::setw(2) << bucket << (bucket + 1 < histogram.size() ? "-" + std::to_string(bucket + 1) : "+ ")
+               << "ms " << std::setw(5) << histogram[bucket] << " "
+               << std::string(histogram[bucket] * 50 / history.size(), '#') << std::endl;
+    }
+
+    for (std::size_t zone = 0; zone < kZones.size(); ++zone) {
+        output << "  " << std::left << std::setw(22) << kZones[zone].name << std::right
+               << std::setw(8) << Milliseconds(average.zoneTime[zone]) << "ms "
+               << std::setw(7) << average.zoneCalls[zone] << " calls per frame" << std::endl;
+    }
+}
+
+#endif //POKESYNCH_PROFILER
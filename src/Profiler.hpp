@@ -0,0 +1,133 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_PROFILER_HPP
+#define GAMEBOYEMULATOR_PROFILER_HPP
+
+// Only built with -DENABLE_PROFILER=ON (which defines POKESYNCH_PROFILER). Otherwise PROFILE_SCOPE expands to nothing
+// and none of this is compiled.
+#ifdef POKESYNCH_PROFILER
+
+#include <stdint.h>
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Parts of a frame that are timed separately. Zones nest (Timer::Increment runs inside the CPU loop and renders each
+ * scanline), and each zone's time includes the zones inside it.
+ */
+enum class ProfileZone {
+    CPU,
+    TIMER,
+    SCANLINE,
+    DISPLAY_FRAME,
+    NETWORK,
+    DISPLAY_PLAYERS,
+    PRESENT,
+    COUNT
+};
+
+/**
+ * Where the time of each zone went over one frame.
+ */
+struct FrameProfile {
+    std::chrono::nanoseconds frameTime{0}; // From the start of the frame until its last zone finished
+    std::array<std::chrono::nanoseconds, static_cast<std::size_t>(ProfileZone::COUNT)> zoneTime{};
+    std::array<uint32_t, static_cast<std::size_t>(ProfileZone::COUNT)> zoneCalls{};
+};
+
+/**
+ * One timed zone for the trace, in microseconds since tracing started.
+ */
+struct TraceEvent {
+    ProfileZone zone;
+    double start;
+    double duration;
+};
+
+/**
+ * Collects per frame timings of each ProfileZone for one GameBoy, keeping the last kHistoryLength frames for
+ * statistics and optionally recording every call of the coarser zones as a Chrome trace (chrome://tracing).
+ *
+ * Each GameBoy binds its profiler to the thread running it at the start of every frame, so zones deep inside the
+ * emulator find it without needing a pointer.
+ */
+class Profiler {
+public:
+    static std::size_t const kHistoryLength = 600; // Ten seconds
+    static std::size_t const kMaxTraceEvents = 1000000;
+
+    Profiler();
+
+    static Profiler* Current() {return current;}
+    static char const* ZoneName(ProfileZone zone);
+
+    void BeginFrame();
+    void AddZone(ProfileZone zone, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    void StartTrace();
+    bool WriteTrace(std::string const& file_name);
+
+    FrameProfile Average() const;
+    std::chrono::nanoseconds FrameTimePercentile(double percentile) const;
+    std::vector<unsigned int> FrameTimeHistogram(std::chrono::nanoseconds bucketWidth, std::size_t buckets) const;
+    std::vector<std::string> OverlayLines() const;
+    void Report(std::ostream& output) const;
+
+    bool showOverlay;
+
+private:
+    static thread_local Profiler* current;
+
+    std::vector<FrameProfile> history; // Ring buffer of the last kHistoryLength frames
+    std::size_t nextHistory;
+    FrameProfile frame;
+    bool frameStarted;
+    std::chrono::steady_clock::time_point frameStart;
+    std::chrono::steady_clock::time_point lastZoneEnd;
+
+    bool tracing;
+    std::chrono::steady_clock::time_point traceStart;
+    std::vector<TraceEvent> traceEvents;
+    std::vector<FrameProfile> traceFrames; // Per frame totals while tracing, written as counters
+    std::vector<double> traceFrameStarts;
+
+    void EndFrame();
+};
+
+/**
+ * Times its own lifetime as a call of the zone, against the profiler bound to this thread.
+ */
+class ScopedProfile {
+public:
+    explicit ScopedProfile(ProfileZone zone_)
+        : zone(zone_)
+        , start(std::chrono::steady_clock::now()) {
+    }
+
+    ~ScopedProfile() {
+        if (auto profiler = Profiler::Current()) {
+            profiler->AddZone(zone, start, std::chrono::steady_clock::now());
+        }
+    }
+
+private:
+    ProfileZone zone;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+#define PROFILE_SCOPE(zone) ScopedProfile PROFILE_CONCATENATE(profile_scope_, __LINE__)(zone)
+
+#else
+
+#define PROFILE_SCOPE(zone)
+
+#endif //POKESYNCH_PROFILER
+
+#endif //GAMEBOYEMULATOR_PROFILER_HPP
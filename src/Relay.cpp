@@ -0,0 +1,323 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "Relay.hpp"
+#include "InstanceHost.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <utility>
+
+Relay::Relay()
+    : reportLinks(false)
+    , clientTimeout(std::chrono::seconds(5))
+    , uniqueId(0)
+    , sequence(0) {
+}
+
+/**
+ * Listens for clients on the port, returning false if it can't be bound.
+ */
+bool Relay::Start(unsigned short port) {
+    if (!socket.Bind(port)) {
+        std::cout << "Failed to bind to socket." << std::endl;
+        return false;
+    }
+    socket.SetBlocking(false);
+    receiver.Watch(socket, [this] {Receive();});
+    if (!receiver.Start()) {
+        std::cout << "Failed to start receiving, so packets will only be read each tick." << std::endl;
+    }
+
+    std::srand(std::time(0));
+    uniqueId = std::rand();
+    std::cout << "Relaying on port: " << port << " with uniqueId: " << uniqueId << std::endl;
+    reportedAt = std::chrono::steady_clock::now();
+    return true;
+}
+
+/**
+ * Sends every client the game state of all of them (after handling the packets that arrived since the last tick, if
+ * they aren't being handled as they arrive).
+ */
+void Relay::Tick() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cpuStart = InstanceHost::ThreadCpuTime();
+    if (!receiver.Running()) {
+        ReceivePackets();
+    }
+    EvictSilentClients();
+    SendHostGameState();
+    auto cpuTime = InstanceHost::ThreadCpuTime() - cpuStart;
+
+    ++stats.ticks;
+    stats.cpuTime += cpuTime;
+    stats.maxTickCpuTime = std::max(stats.maxTickCpuTime, cpuTime);
+}
+
+/**
+ * Prints what the relay did since the last report (and every client's link, with reportLinks), and resets the worst
+ * tick.
+ */
+void Relay::Report(std::ostream& output) {
+    std::lock_guard<std::mutex> lock(mutex);
+    double ticks = std::max<double>(stats.ticks - reported.ticks, 1);
+    auto cpuTime = stats.cpuTime - reported.cpuTime;
+
+    output << std::fixed << std::setprecision(3)
+           << "Clients: " << clients.size()
+           << "\tTicks: " << stats.ticks - reported.ticks
+           << "\tIn: " << stats.packetsIn - reported.packetsIn << " packets, " << stats.bytesIn - reported.bytesIn << " bytes"
+           << "\tOut: " << stats.packetsOut - reported.packetsOut << " packets, " << stats.bytesOut - reported.bytesOut << " bytes"
+           << "\tFailed sends: " << stats.failedSends - reported.failedSends
+           << "\tEvicted: " << stats.evictions - reported.evictions << std::endl
+           << "CPU per tick: " << cpuTime.count()/ticks/1e6 << "ms average, " << stats.maxTickCpuTime.count()/1e6 << "ms worst, "
+           << (stats.receiveCpuTime - reported.receiveCpuTime).count()/ticks/1e6 << "ms receiving between"
+           << "\tSent per tick: " << (stats.bytesOut - reported.bytesOut)/ticks << " bytes" << std::endl;
+    datagramSizes.Write(output);
+
+    auto now = std::chrono::steady_clock::now();
+    if (reportLinks) {
+        auto seconds = std::chrono::duration<double>(now - reportedAt).count();
+        for (auto const& link : links) {
+            output << "Link to " << clients[link.first].name << " (" << link.first << ")\t";
+            link.second.Write(output, reportedLinks[link.first], seconds);
+        }
+        reportedLinks = links;
+    }
+
+    stats.maxTickCpuTime = std::chrono::nanoseconds(0);
+    reported = stats;
+    reportedAt = now;
+}
+
+std::size_t Relay::NumberOfClients() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return clients.size();
+}
+
+RelayStats Relay::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::unordered_map<int, LinkStats> Relay::Links() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return links;
+}
+
+/**
+ * Handles every packet waiting on the socket, on receiver's thread.
+ */
+void Relay::Receive() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cpuStart = InstanceHost::ThreadCpuTime();
+    ReceivePackets();
+    stats.receiveCpuTime += InstanceHost::ThreadCpuTime() - cpuStart;
+}
+
+void Relay::ReceivePackets() {
+    auto received = socket.ReceiveBatch(receivedDatagrams);
+    auto receivedAt = std::chrono::steady_clock::now();
+    for (std::size_t index = 0; index < received; ++index) {
+        auto& datagram = receivedDatagrams[index];
+        ++stats.packetsIn;
+        stats.bytesIn += datagram.packet.getDataSize();
+        auto client = clientsByEndpoint.find(EndpointKey(datagram.sender, datagram.port));
+        if (client != clientsByEndpoint.end()) {
+            links[client->second].bytesIn += datagram.packet.getDataSize();
+            clients[client->second].lastHeard = receivedAt;
+        }
+
+        int packetType = 0;
+        datagram.packet >> packetType;
+        if (!datagram.packet) {
+            continue; // Too short to have a type, so it's counted but never handled
+        } else if (packetType == static_cast<int>(PacketType::CONNECT_REQUEST)) {
+            HandleConnectRequest(datagram.packet, datagram.sender, datagram.port);
+        } else if (packetType == static_cast<int>(PacketType::NETWORK_GAME_STATE)) {
+            if (client != clientsByEndpoint.end()) {
+                HandleGameState(datagram.packet, client->second, receivedAt);
+            } else {
+                // Evicted, or connected before the relay started again, so they have to connect again to be sent anything
+                sf::Packet rejoinPacket;
+                rejoinPacket << static_cast<int>(PacketType::REJOIN);
+                Send(rejoinPacket, datagram.sender, datagram.port);
+            }
+        } else if (packetType == static_cast<int>(PacketType::PARTY_REQUEST)) {
+            HandlePartyRequest(datagram.packet, datagram.sender, datagram.port);
+        } else if (packetType == static_cast<int>(PacketType::PARTIES)) {
+            // Only a client's are cached, so no one else can fill the cache up and push theirs out
+            if (client != clientsByEndpoint.end() and ReadParties(datagram.packet, receivedParties)) {
+                for (auto const& party : receivedParties) {
+                    parties.Insert(party.data());
+                }
+            }
+        }
+        // Generic requests are addressed to the host or another player directly, never to the relay
+    }
+}
+
+/**
+ * Adds the sender as a client and responds with their uniqueId. A client asking again (their response was lost) gets
+ * the same uniqueId back, and one rejoining gets the one they asked for unless someone else has it. No one new is
+ * answered once there are kMaxPlayers clients.
+ */
+void Relay::HandleConnectRequest(sf::Packet& packet, sf::IpAddress const& sender, unsigned short port) {
+    ConnectRequest request;
+    packet >> request;
+    if (!packet) return; // Too short to hold a request, so its uniqueId can't be trusted
+
+    auto endpoint = EndpointKey(sender, port);
+    auto existing = clientsByEndpoint.find(endpoint);
+    if (existing == clientsByEndpoint.end() and clients.size() >= kMaxPlayers) {
+        return; // Full, so they're left to keep asking until someone leaves
+    }
+    ConnectResponse response;
+    response.serverUniqueId = uniqueId;
+    if (existing != clientsByEndpoint.end()) {
+        response.uniqueId = existing->second;
+    } else {
+        if (request.uniqueId != 0 and request.uniqueId != uniqueId and !clients.count(request.uniqueId)) {
+            response.uniqueId = request.uniqueId;
+        } else {
+            do {
+                response.uniqueId = std::rand();
+            } while (response.uniqueId == 0 or response.uniqueId == uniqueId or clients.count(response.uniqueId));
+        }
+
+        NetworkId clientId;
+        clientId.uniqueId = response.uniqueId;
+        clientId.name = request.name;
+        clientId.address = sender;
+        clientId.port = port;
+        clientId.lastHeard = std::chrono::steady_clock::now();
+        clients[clientId.uniqueId] = clientId;
+        clientsByEndpoint[endpoint] = clientId.uniqueId;
+        clientEndpoints.push_back({sender, port});
+        std::cout << "Client connected: " << request.name << " (" << clientId.uniqueId << ")" << std::endl;
+    }
+
+    sf::Packet responsePacket;
+    responsePacket << static_cast<int>(PacketType::CONNECT_RESPONSE) << response;
+    Send(responsePacket, sender, port);
+}
+
+/**
+ * Keeps the game state a connected client sent, if it's their own, measures their link with it, and asks them for their
+ * party if it isn't cached yet (so it can be passed on to whoever else asks for it).
+ */
+void Relay::HandleGameState(sf::Packet& packet, int clientId, std::chrono::steady_clock::time_point receivedAt) {
+    packet >> receivedGameState;
+    if (!packet or receivedGameState.uniqueId != clientId) return;
+
+    // Swapped rather than copied, so both keep their allocations for the next time
+    auto& gameState = clientGameStates[clientId];
+    std::swap(gameState, receivedGameState);
+
+    auto& link = links[clientId];
+    link.Received(gameState.number, receivedAt);
+    std::chrono::steady_clock::time_point sentAt;
+    if (sendTimes.Find(gameState.echo.sequence, sentAt)) {
+        link.RoundTrip(sentAt, gameState.echo, receivedAt);
+    }
+
+    if (!parties.Find(gameState.partyHash)) {
+        auto const& client = clients[clientId];
+        sf::Packet requestPacket;
+        WritePartyRequest(requestPacket, {gameState.partyHash});
+        Send(requestPacket, client.address, client.port);
+    }
+}
+
+/**
+ * Drops every client that hasn't sent anything in clientTimeout, so nothing more is sent to them or about them.
+ */
+void Relay::EvictSilentClients() {
+    auto now = std::chrono::steady_clock::now();
+    bool evicted = false;
+    for (auto client = clients.begin(); client != clients.end();) {
+        if (now - client->second.lastHeard < clientTimeout) {
+            ++client;
+            continue;
+        }
+
+        std::cout << "Client timed out: " << client->second.name << " (" << client->first << ")" << std::endl;
+        clientsByEndpoint.erase(EndpointKey(client->second.address, client->second.port));
+        clientGameStates.erase(client->first);
+        links.erase(client->first);
+        reportedLinks.erase(client->first);
+        client = clients.erase(client);
+        ++stats.evictions;
+        evicted = true;
+    }
+
+    if (evicted) {
+        clientEndpoints.clear();
+        for (auto const& client : clients) {
+            clientEndpoints.push_back({client.second.address, client.second.port});
+        }
+    }
+}
+
+/**
+ * Answers a client asking for parties with those that are cached, at most one for each client. Anyone else is ignored,
+ * as they could be naming someone else to send them to.
+ */
+void Relay::HandlePartyRequest(sf::Packet& packet, sf::IpAddress const& sender, unsigned short port) {
+    if (!clientsByEndpoint.count(EndpointKey(sender, port)) or !ReadPartyRequest(packet, partyHashes)) return;
+    auto count = WritePartiesMessages(partyMessages, partyHashes, parties, clients.size());
+    for (std::size_t index = 0; index < count; ++index) {
+        Send(partyMessages[index], sender, port);
+    }
+}
+
+/**
+ * Sends a packet to one client, counting it in the stats.
+ */
+void Relay::Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) {
+    if (socket.Send(packet, address, port) == sf::Socket::Done) {
+        ++stats.packetsOut;
+        stats.bytesOut += packet.getDataSize();
+        auto client = clientsByEndpoint.find(EndpointKey(address, port));
+        if (client != clientsByEndpoint.end()) {
+            links[client->second].bytesOut += packet.getDataSize();
+        }
+    } else {
+        ++stats.failedSends;
+    }
+}
+
+/**
+ * Sends every client the game state of every client that has sent one, in messages built once for all of them, each
+ * player's with the relay's echo of them. There are no sprites to send, as there's no game here to take them from.
+ */
+void Relay::SendHostGameState() {
+    if (clientGameStates.empty()) return;
+
+    auto now = std::chrono::steady_clock::now();
+    players.clear();
+    for (auto& gameState : clientGameStates) {
+        gameState.second.echo = links[gameState.first].Echo(now);
+        players.push_back(&gameState.second);
+    }
+    auto messageCount = WriteHostGameStateMessages(hostGameStateMessages, players, nullptr, sequence);
+
+    std::size_t bytesPerClient = 0;
+    for (std::size_t index = 0; index < messageCount; ++index) {
+        auto& message = hostGameStateMessages[index];
+        auto sent = socket.SendToAll(message, clientEndpoints);
+        stats.packetsOut += sent;
+        stats.bytesOut += sent * message.getDataSize();
+        stats.failedSends += clientEndpoints.size() - sent;
+        datagramSizes.Add(message.getDataSize(), sent);
+        sendTimes.Record(sequence - static_cast<uint32_t>(messageCount - 1 - index), now);
+        bytesPerClient += message.getDataSize();
+    }
+    for (auto const& client : clients) {
+        links[client.first].bytesOut += bytesPerClient;
+    }
+}
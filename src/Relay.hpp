@@ -0,0 +1,102 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_RELAY_HPP
+#define GAMEBOYEMULATOR_RELAY_HPP
+
+#include <stdint.h>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#include "DatagramTransport.hpp"
+#include "EventLoop.hpp"
+#include "LinkStats.hpp"
+#include "Network.hpp"
+
+/**
+ * Accounting for a Relay's ticks.
+ */
+struct RelayStats {
+    uint64_t ticks = 0;
+    uint64_t packetsIn = 0;
+    uint64_t bytesIn = 0;
+    uint64_t packetsOut = 0;
+    uint64_t bytesOut = 0;
+    uint64_t failedSends = 0;
+    uint64_t evictions = 0; // Clients dropped for going clientTimeout without sending anything
+    std::chrono::nanoseconds cpuTime{0}; // Spent ticking
+    std::chrono::nanoseconds maxTickCpuTime{0};
+    std::chrono::nanoseconds receiveCpuTime{0}; // Spent handling packets as they arrive, between ticks
+};
+
+/**
+ * Stands in for the host of a session without running a game, so the session isn't limited by what one player's frame
+ * loop can take on. Clients connect and send their game state to it exactly as they would to a host, and every tick it
+ * sends all of them everyone's. Packets are handled as they arrive, on a thread of its own, rather than waiting for the
+ * next tick, so a burst of them never has to fit in the socket's buffer for a whole tick.
+ *
+ * With no game of its own there are no host sprites to send, so clients don't synchronize NPCs, and battles (which are
+ * only ever between a client and the host) aren't available.
+ */
+class Relay {
+public:
+    Relay();
+
+    bool Start(unsigned short port);
+    void Tick();
+    void Report(std::ostream& output);
+
+    std::size_t NumberOfClients() const;
+    RelayStats Stats() const;
+    std::unordered_map<int, LinkStats> Links() const; // Every client's, by uniqueId
+
+    bool reportLinks; // Whether Report prints every client's link as well
+    std::chrono::milliseconds clientTimeout; // How long a client can go without sending anything before being evicted
+
+private:
+    DatagramTransport socket;
+    int uniqueId;
+    std::unordered_map<int, NetworkId> clients; // UniqueId, NetworkId
+    std::unordered_map<uint64_t, int> clientsByEndpoint; // Address and port (see EndpointKey), UniqueId
+    std::unordered_map<int, NetworkGameState> clientGameStates; // UniqueId, NetworkGameState
+
+    std::vector<ReceivedDatagram> receivedDatagrams; // Reused for every tick's packets
+    std::vector<DatagramEndpoint> clientEndpoints; // Kept alongside clients, for sending to all of them
+    std::vector<const NetworkGameState*> players; // Everyone in clientGameStates, for writing hostGameStateMessages
+    std::vector<sf::Packet> hostGameStateMessages; // Built once a tick and sent to every client
+    DatagramSizeHistogram datagramSizes; // Of every game state message sent since starting
+    NetworkGameState receivedGameState; // Reused to read game states into before they're checked
+
+    PartyCache parties; // Every client's, to answer the others asking for them
+    std::vector<uint64_t> partyHashes; // Reused for every PARTY_REQUEST
+    std::vector<Party> receivedParties; // Reused for every PARTIES
+    std::vector<sf::Packet> partyMessages; // Reused to answer every PARTY_REQUEST
+
+    RelayStats stats;
+    RelayStats reported; // stats at the last Report, to print the change since
+    std::chrono::steady_clock::time_point reportedAt;
+
+    // Game states are only passed on each tick, so the relay's round trips (and its clients') include up to a tick spent
+    // waiting for it, which is as long as they really take to be passed on
+    std::unordered_map<int, LinkStats> links; // UniqueId, LinkStats
+    std::unordered_map<int, LinkStats> reportedLinks; // links at the last Report
+    uint32_t sequence; // Of the last game state message sent
+    SendTimes sendTimes; // Of the game state messages, for the round trips to the clients echoing them
+
+    mutable std::mutex mutex; // Over everything above, as packets are handled on receiver's thread and ticks on the caller's
+    EventLoop receiver; // Last, so it's stopped before anything it handles packets with is destroyed
+
+    void Receive();
+    void ReceivePackets();
+    void HandleConnectRequest(sf::Packet& packet, sf::IpAddress const& sender, unsigned short port);
+    void HandleGameState(sf::Packet& packet, int clientId, std::chrono::steady_clock::time_point receivedAt);
+    void EvictSilentClients();
+    void HandlePartyRequest(sf::Packet& packet, sf::IpAddress const& sender, unsigned short port);
+    void Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port);
+    void SendHostGameState();
+};
+
+#endif //GAMEBOYEMULATOR_RELAY_HPP
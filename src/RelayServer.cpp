@@ -0,0 +1,67 @@
+//
+// Created by Austin on 10/19/2026.
+//
+// Runs a session's host without a game (see Relay), for sessions bigger than a player's own instance can host. Clients
+// connect to it with -connect= and -hostport= as they would to a host:
+//
+//   RelayServer [-port=N] [-tick=MS] [-duration=SECONDS] [-timeout=SECONDS] [-link-stats]
+//
+// Ticks every 12 frames by default, as often as players send their game state, handling packets as they arrive in
+// between. Reports every few seconds how long the ticks took and how much was sent (and with -link-stats, every
+// client's round trip, jitter, loss and byte rates), and runs until the duration elapses, or forever if it is 0.
+// Clients that send nothing for the timeout (5 seconds by default) are dropped.
+//
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std::literals;
+
+#include "InstanceHost.hpp"
+#include "Relay.hpp"
+
+int main(int argc, char* argv[]) {
+    unsigned short port = 34232;
+    std::chrono::nanoseconds tick = 12*kFrameDuration;
+    int duration = 0;
+    bool linkStats = false;
+    int timeout = 5;
+    for (int argument = 1; argument < argc; ++argument) {
+        auto arg = std::string(argv[argument]);
+        if (arg.find("-port=") == 0) {
+            port = std::stoi(arg.substr(6));
+        } else if (arg.find("-tick=") == 0) {
+            tick = std::chrono::milliseconds(std::stoi(arg.substr(6)));
+        } else if (arg.find("-duration=") == 0) {
+            duration = std::stoi(arg.substr(10));
+        } else if (arg.find("-timeout=") == 0) {
+            timeout = std::stoi(arg.substr(9));
+        } else if (arg == "-link-stats") {
+            linkStats = true;
+        }
+    }
+
+    Relay relay;
+    relay.reportLinks = linkStats;
+    relay.clientTimeout = std::chrono::seconds(timeout);
+    if (!relay.Start(port)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto nextTick = start + tick;
+    auto nextReport = start + 5s;
+    while (duration == 0 or std::chrono::steady_clock::now() - start < std::chrono::seconds(duration)) {
+        relay.Tick();
+        if (std::chrono::steady_clock::now() >= nextReport) {
+            relay.Report(std::cout);
+            nextReport += 5s;
+        }
+
+        std::this_thread::sleep_until(nextTick);
+        nextTick += tick;
+    }
+    relay.Report(std::cout);
+    return 0;
+}
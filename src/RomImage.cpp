@@ -0,0 +1,173 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#include "RomImage.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RomImage::RomImage()
+    : data(nullptr)
+    , size(0)
+    , mapping(nullptr)
+    , mapping_size(0) {
+}
+
+RomImage::~RomImage() {
+    if (mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+#else
+        munmap(mapping, mapping_size);
+#endif
+    }
+}
+
+/**
+ * Returns the image for the given file, mapping it if no other instance in this process has it open. Returns nullptr
+ * if the file can't be read.
+ */
+std::shared_ptr<const RomImage> RomImage::Open(std::string const& file_name) {
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const RomImage>> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto cached = cache.find(file_name);
+    if (cached != cache.end()) {
+        if (auto image = cached->second.lock()) {
+            return image;
+        }
+    }
+
+    std::shared_ptr<RomImage> image(new RomImage());
+    image->file_name = file_name;
+    if (!image->Map() and !image->Read()) {
+        return nullptr;
+    }
+    image->BuildBankTable();
+
+    cache[file_name] = image;
+    return image;
+}
+
+/**
+ * Returns a blank (all zero) two bank image, used before a game is loaded.
+ */
+std::shared_ptr<const RomImage> RomImage::Empty() {
+    static std::shared_ptr<const RomImage> const empty = [](){
+        std::shared_ptr<RomImage> image(new RomImage());
+        image->buffer = std::vector<uint8_t>(2*kBankSize, 0);
+        image->data = image->buffer.data();
+        image->size = image->buffer.size();
+        image->BuildBankTable();
+        return image;
+    }();
+    return empty;
+}
+
+/**
+ * Maps the file read-only. Banks are paged in on first access rather than read ahead, so a game only keeps the banks
+ * it uses resident. Returns false if the file can't be mapped or isn't a whole number of banks (see Read).
+ */
+bool RomImage::Map() {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) or file_size.QuadPart < 2*kBankSize or file_size.QuadPart % kBankSize != 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* view = file_mapping ? MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (file_mapping) {
+        CloseHandle(file_mapping); // The view keeps the mapping alive
+    }
+    CloseHandle(file);
+    if (!view) {
+        return false;
+    }
+
+    size = static_cast<std::size_t>(file_size.QuadPart);
+    mapping = view;
+    mapping_size = size;
+#else
+    int file = open(file_name.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat file_status;
+    if (fstat(file, &file_status) != 0 or file_status.st_size < 0) {
+        close(file);
+        return false;
+    }
+    auto file_size = static_cast<std::size_t>(file_status.st_size);
+    if (file_size < 2*kBankSize or file_size % kBankSize != 0) {
+        close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file); // The mapping keeps its own reference to the file
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    size = file_size;
+    mapping = view;
+    mapping_size = size;
+    madvise(view, size, MADV_RANDOM); // Don't read ahead banks the game hasn't switched to
+    madvise(view, kBankSize, MADV_WILLNEED); // Bank 0 is always mapped in
+#endif
+
+    data = static_cast<const uint8_t*>(mapping);
+    return true;
+}
+
+/**
+ * Reads the file into memory, padding it with zeros to a whole number of banks (at least two).
+ */
+bool RomImage::Read() {
+    std::ifstream input(file_name, std::ios::in | std::ios::binary);
+    if (!input) {
+        return false;
+    }
+
+    buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    std::size_t padded_size = ((buffer.size() + kBankSize - 1) / kBankSize) * kBankSize;
+    buffer.resize(std::max(padded_size, 2*kBankSize), 0);
+
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
+
+/**
+ * Points each bank number at its bank in the image. Like the cartridge's address lines, bank numbers larger than the
+ * ROM wrap back around to the start.
+ */
+void RomImage::BuildBankTable() {
+    std::size_t number_of_banks = size / kBankSize;
+    for (std::size_t bank = 0; bank < kMaxBanks; ++bank) {
+        banks[bank] = data + (bank % number_of_banks) * kBankSize;
+    }
+}
@@ -0,0 +1,56 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_ROMIMAGE_HPP
+#define GAMEBOYEMULATOR_ROMIMAGE_HPP
+
+#include <stdint.h>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only cartridge ROM, memory mapped from disk and shared by every emulator instance that opens the same file.
+ *
+ * The file is mapped once per process (later Open calls for the same file return the same image) and the mapping is
+ * shared, so instances in other processes on the same machine reuse the same page cache pages. Only the banks the game
+ * actually touches are ever faulted in.
+ */
+class RomImage {
+public:
+    static std::size_t const kBankSize = 0x4000; // 16KB
+    static std::size_t const kMaxBanks = 0x200; // MBC5 addresses up to 512 banks (8MB)
+
+    static std::shared_ptr<const RomImage> Open(std::string const& file_name);
+    static std::shared_ptr<const RomImage> Empty();
+
+    ~RomImage();
+    RomImage(RomImage const&) = delete;
+    RomImage& operator=(RomImage const&) = delete;
+
+    // Table of kMaxBanks pointers to each 16KB bank, where bank numbers past the end of the ROM wrap around
+    const uint8_t* const* Banks() const {return banks.data();}
+    const uint8_t* Bank(unsigned int bank) const {return banks[bank % kMaxBanks];}
+    std::size_t Size() const {return size;}
+    bool IsMapped() const {return mapping != nullptr;}
+    std::string const& FileName() const {return file_name;}
+
+private:
+    RomImage();
+
+    std::string file_name;
+    const uint8_t* data;
+    std::size_t size;
+    void* mapping; // Start of the memory mapped view (nullptr if the file was read into buffer instead)
+    std::size_t mapping_size;
+    std::vector<uint8_t> buffer; // Used when the file can't be mapped or isn't a whole number of banks
+    std::array<const uint8_t*, kMaxBanks> banks;
+
+    bool Map();
+    bool Read();
+    void BuildBankTable();
+};
+
+#endif //GAMEBOYEMULATOR_ROMIMAGE_HPP
@@ -0,0 +1,666 @@
+//
+// Created by Austin on 10/19/2026.
+//
+// Loads a host with a swarm of bots that speak the same protocol as a client (CONNECT_REQUEST, then a NETWORK_GAME_STATE
+// every update, asking for and answering PARTY_REQUESTs), with no emulator behind any of them, to see how a host holds
+// up with many players before it has them. Each bot walks laps across a few maps, changes its party every 20 seconds and
+// asks the host to battle every 30, all staggered so they don't act in step. The run is repeated for each number of bots:
+//
+//   SwarmLoad -game=ROM [-save=FILE] [-clients=8,64,256] [-duration=SECONDS] [-port=N] [-verbose]
+//   SwarmLoad -relay [-tick=MS] [-clients=8,64,256] [-duration=SECONDS] [-port=N]
+//   SwarmLoad -host=IP [-port=N] [-clients=8,64,256] [-duration=SECONDS]
+//
+// With -game a host is run headless in this process (as PokeSynch runs one), and with -relay a Relay is, so their ticks
+// can be timed: for a game, the time its frames spent on the network between one game state exchange and the next; for
+// the relay, the CPU time of its Tick. With -host an existing host or RelayServer is loaded instead, and only what the
+// bots see of it is measured.
+//
+// For each number of bots it prints the host's tick time, the packets lost each way (to the host only when it's in this
+// process), the bots' round trips, and how stale the other players' positions were when they arrived: the time from a
+// bot sending its game state to another bot receiving it in the host's. The host's own output is hidden unless -verbose.
+//
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "EventLoop.hpp"
+#include "GameBoy.hpp"
+#include "InstanceHost.hpp"
+#include "Relay.hpp"
+
+namespace {
+    std::chrono::nanoseconds const kUpdateInterval = 12*kFrameDuration; // As often as a player sends their game state
+    std::chrono::milliseconds const kConnectRetry(500);
+    std::chrono::milliseconds const kHostTimeout(5000); // As Network's, after which a bot connects again
+    std::chrono::milliseconds const kPollInterval(1); // How often the swarm checks for bots due to update
+
+    int const kMaps[] = {0x00, 0x0C, 0x01, 0x21}; // Pallet Town, Route 1, Viridian City, Route 22
+    int const kMapCount = sizeof(kMaps) / sizeof(kMaps[0]);
+    int const kLapSide = 8; // Steps along each side of the square a bot walks on each map
+    uint64_t const kPartyChangeUpdates = 100; // 20 seconds
+    uint64_t const kBattleRequestUpdates = 150; // 30 seconds
+    int const kBattleRequestRepeats = 5; // Updates a battle request is sent for, unanswered, before the bot moves on
+
+    double Milliseconds(std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+/**
+ * Discards whatever is written to it, for hiding the host's output.
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int character) override {return character;}
+};
+
+/**
+ * Milliseconds bucketed by the millisecond (up to kBuckets), for percentiles without keeping every sample.
+ */
+class Histogram {
+public:
+    static std::size_t const kBuckets = 5000;
+
+    void Add(double milliseconds) {
+        ++buckets[std::min(static_cast<std::size_t>(std::max(milliseconds, 0.0)), kBuckets)];
+        ++count;
+        total += milliseconds;
+        max = std::max(max, milliseconds);
+    }
+
+    /**
+     * The bucket below which the fraction of samples fall, in milliseconds.
+     */
+    double Percentile(double fraction) const {
+        uint64_t below = 0;
+        for (std::size_t bucket = 0; bucket <= kBuckets; ++bucket) {
+            below += buckets[bucket];
+            if (below >= fraction * count) return static_cast<double>(bucket);
+        }
+        return max;
+    }
+
+    uint64_t Count() const {return count;}
+    double Average() const {return count > 0 ? total / count : 0;}
+    double Max() const {return max;}
+
+private:
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(kBuckets + 1); // The last for anything longer
+    uint64_t count = 0;
+    double total = 0;
+    double max = 0;
+};
+
+std::size_t const Histogram::kBuckets;
+
+/**
+ * What the bots saw over a run, and how the host did if it was in this process.
+ */
+struct SwarmResult {
+    std::size_t clients = 0;
+    std::size_t connected = 0;
+    double slowestConnect = 0; // Milliseconds
+    uint64_t rejoins = 0;
+    uint64_t partyChanges = 0;
+    uint64_t battleRequests = 0;
+
+    uint64_t packetsExpected = 0; // Numbered messages from the host, over every bot
+    uint64_t packetsLost = 0;
+    double roundTrip = 0; // Milliseconds, the average of the bots'
+    Histogram staleness;
+
+    bool hostMeasured = false; // Whether the rest was measured, which it is for a host in this process
+    double averageTick = 0; // Milliseconds
+    double worstTick = 0;
+    uint64_t hostPacketsExpected = 0; // Game states from the bots
+    uint64_t hostPacketsLost = 0;
+};
+
+class Swarm;
+
+/**
+ * One impersonated client, sending a scripted game state from a WRAM of its own rather than an emulator's.
+ */
+class Bot {
+public:
+    Bot(std::size_t index, std::size_t swarmSize, sf::IpAddress host, unsigned short hostPort);
+
+    bool Start(std::chrono::steady_clock::time_point now);
+    void Update(Swarm& swarm, std::chrono::steady_clock::time_point now);
+    void Receive(Swarm& swarm, std::vector<ReceivedDatagram>& datagrams);
+
+    DatagramTransport transport;
+    int uniqueId;
+    bool connected;
+    std::chrono::steady_clock::time_point startedAt;
+    std::chrono::steady_clock::time_point connectedAt;
+    uint64_t rejoins;
+    uint64_t partyChanges;
+    uint64_t battleRequests;
+    LinkStats link; // To the host
+    SendTimes sendTimes; // Of game states, for round trips, and for how stale they were when other bots got them
+
+private:
+    std::size_t index;
+    std::string name;
+    sf::IpAddress host;
+    unsigned short hostPort;
+    int hostUniqueId;
+    std::chrono::steady_clock::time_point nextUpdate;
+    std::chrono::steady_clock::time_point nextConnectAttempt;
+    std::chrono::steady_clock::time_point lastHeard; // From the host
+    uint64_t updates;
+    uint32_t sequence;
+    int battleRequestsLeft; // Updates the current battle request is still sent for
+
+    std::vector<uint8_t> wram;
+    PartyCache parties; // Our own, to answer PARTY_REQUESTs
+    uint64_t partyHash;
+    std::unordered_set<uint64_t> knownParties; // Everyone else's that have arrived
+    std::vector<uint64_t> wantedParties;
+    std::vector<uint64_t> partyHashes;
+    std::vector<Party> receivedParties;
+    std::vector<sf::Packet> partyMessages;
+    HostGameStatePart part;
+
+    void SendConnectRequest(std::chrono::steady_clock::time_point now);
+    void Walk();
+    void ChangeParty();
+    void Send(sf::Packet& packet);
+    void HandleHostPlayers(Swarm& swarm, std::chrono::steady_clock::time_point receivedAt);
+};
+
+/**
+ * Every bot, run on an event loop of their own so the host (in this process or not) isn't slowed by them.
+ */
+class Swarm {
+public:
+    Swarm(std::size_t size, sf::IpAddress host, unsigned short hostPort);
+
+    bool Start();
+    void Stop();
+    void Collect(SwarmResult& result) const; // Only once stopped
+
+    Histogram staleness;
+    std::unordered_map<int, Bot*> botsById; // Connected bots, to look up when their game states were sent
+
+private:
+    std::vector<std::unique_ptr<Bot>> bots;
+    std::vector<ReceivedDatagram> received; // Reused for every bot's datagrams, as they're all read on one thread
+    EventLoop eventLoop; // Last, so it stops before the bots are destroyed
+};
+
+Bot::Bot(std::size_t index, std::size_t swarmSize, sf::IpAddress host, unsigned short hostPort)
+    : uniqueId(0)
+    , connected(false)
+    , rejoins(0)
+    , partyChanges(0)
+    , battleRequests(0)
+    , index(index)
+    , name("bot" + std::to_string(index))
+    , host(host)
+    , hostPort(hostPort)
+    , hostUniqueId(0)
+    , updates(0)
+    , sequence(0)
+    , battleRequestsLeft(0)
+    , wram(0x2000, 0)
+    , partyHash(0) {
+    // Spread across one update, so the bots' game states don't all arrive together
+    nextUpdate = std::chrono::steady_clock::now() + kUpdateInterval * index / swarmSize;
+
+    auto party = &wram[0xD163 & 0x1FFF];
+    party[0] = static_cast<uint8_t>(1 + index % 6); // How many pokemon
+    for (std::size_t offset = 1; offset < std::tuple_size<Party>::value; ++offset) {
+        party[offset] = static_cast<uint8_t>(index * 7 + offset);
+    }
+    partyHash = parties.Insert(party);
+    wram[0xC100 & 0x1FFF] = 1; // The player's sprite
+}
+
+bool Bot::Start(std::chrono::steady_clock::time_point now) {
+    if (!transport.Bind(0)) return false;
+    transport.SetBlocking(false);
+    startedAt = now;
+    SendConnectRequest(now);
+    return true;
+}
+
+/**
+ * Asks to connect, with the uniqueId we had if we're rejoining.
+ */
+void Bot::SendConnectRequest(std::chrono::steady_clock::time_point now) {
+    ConnectRequest request;
+    request.name = name;
+    request.uniqueId = uniqueId;
+    sf::Packet requestPacket;
+    requestPacket << static_cast<int>(PacketType::CONNECT_REQUEST) << request;
+    Send(requestPacket);
+    nextConnectAttempt = now + kConnectRetry;
+}
+
+void Bot::Send(sf::Packet& packet) {
+    link.bytesOut += packet.getDataSize();
+    transport.Send(packet, host, hostPort);
+}
+
+/**
+ * Takes the next step of the lap, moving on to the next map after every lap.
+ */
+void Bot::Walk() {
+    int const kLap = 4*kLapSide;
+    auto step = static_cast<int>((updates + index) % kLap);
+    auto lap = (updates + index) / kLap;
+    auto side = step / kLapSide;
+    auto along = step % kLapSide;
+    int x = 4 + static_cast<int>(index % 8);
+    int y = 4 + static_cast<int>((index / 8) % 8);
+    uint8_t direction = 0;
+    if (side == 0) {
+        x += along;
+        direction = 0xC; // Right
+    } else if (side == 1) {
+        x += kLapSide;
+        y += along;
+        direction = 0x0; // Down
+    } else if (side == 2) {
+        x += kLapSide - along;
+        y += kLapSide;
+        direction = 0x8; // Left
+    } else {
+        y += kLapSide - along;
+        direction = 0x4; // Up
+    }
+
+    wram[0xD35E & 0x1FFF] = static_cast<uint8_t>(kMaps[(index + lap) % kMapCount]);
+    wram[0xD361 & 0x1FFF] = static_cast<uint8_t>(y);
+    wram[0xD362 & 0x1FFF] = static_cast<uint8_t>(x);
+    wram[0xD363 & 0x1FFF] = static_cast<uint8_t>(y % 2);
+    wram[0xD364 & 0x1FFF] = static_cast<uint8_t>(x % 2);
+    wram[0xC109 & 0x1FFF] = direction;
+    wram[0xC204 & 0x1FFF] = static_cast<uint8_t>(y + 4); // Sprites are placed 4 blocks in from the map's
+    wram[0xC205 & 0x1FFF] = static_cast<uint8_t>(x + 4);
+}
+
+/**
+ * Changes a pokemon's HP, as a battle would, so the party has a new hash to be asked for.
+ */
+void Bot::ChangeParty() {
+    auto party = &wram[0xD163 & 0x1FFF];
+    ++party[0x8 + 0x1]; // First pokemon's current HP, low byte
+    partyHash = parties.Insert(party);
+    ++partyChanges;
+}
+
+/**
+ * Sends the bot's game state if an update is due, or asks to connect again if we're waiting on the host.
+ */
+void Bot::Update(Swarm& swarm, std::chrono::steady_clock::time_point now) {
+    if (connected and now - lastHeard >= kHostTimeout) {
+        connected = false; // Lost the host, so ask to rejoin as a client would
+        ++rejoins;
+        swarm.botsById.erase(uniqueId);
+        SendConnectRequest(now);
+    }
+    if (!connected) {
+        if (now >= nextConnectAttempt) SendConnectRequest(now);
+        return;
+    }
+    if (now < nextUpdate) return;
+    nextUpdate += kUpdateInterval;
+    ++updates;
+
+    Walk();
+    if ((updates + index) % kPartyChangeUpdates == 0) ChangeParty();
+
+    sf::Packet gameStatePacket;
+    gameStatePacket << static_cast<int>(PacketType::NETWORK_GAME_STATE);
+    PacketNumber number{++sequence, LinkClock()};
+    sendTimes.Record(sequence, now);
+    WriteGameState(gameStatePacket, uniqueId, name, GameStateView(wram), partyHash, number, link.Echo(now));
+    Send(gameStatePacket);
+
+    if ((updates + index) % kBattleRequestUpdates == 0) {
+        battleRequestsLeft = kBattleRequestRepeats;
+        ++battleRequests;
+    }
+    if (battleRequestsLeft > 0) {
+        --battleRequestsLeft;
+        GenericRequestResponse battleRequest;
+        battleRequest.responseType = ResponseType::REQUEST_BATTLE;
+        battleRequest.data.push_back(hostUniqueId);
+        battleRequest.data.push_back(static_cast<int>(index)); // The battle's random seed
+        sf::Packet requestPacket;
+        requestPacket << static_cast<int>(PacketType::GENERIC_REQUEST) << battleRequest;
+        Send(requestPacket);
+    }
+}
+
+/**
+ * Drains the bot's socket, handling everything from the host as a client would.
+ */
+void Bot::Receive(Swarm& swarm, std::vector<ReceivedDatagram>& datagrams) {
+    auto received = transport.ReceiveBatch(datagrams);
+    auto receivedAt = std::chrono::steady_clock::now();
+    for (std::size_t datagram = 0; datagram < received; ++datagram) {
+        auto& packet = datagrams[datagram].packet;
+        link.bytesIn += packet.getDataSize();
+        lastHeard = receivedAt;
+        int packetType = 0;
+        packet >> packetType;
+        auto type = static_cast<PacketType>(packetType);
+
+        if (type == PacketType::CONNECT_RESPONSE) {
+            ConnectResponse response;
+            packet >> response;
+            if (connected or !packet) continue; // A duplicate, answering a request sent again
+            if (connectedAt == std::chrono::steady_clock::time_point()) connectedAt = receivedAt;
+            uniqueId = response.uniqueId;
+            hostUniqueId = response.serverUniqueId;
+            connected = true;
+            nextUpdate = std::max(nextUpdate, receivedAt);
+            swarm.botsById[uniqueId] = this;
+        } else if (!connected) {
+            continue; // Anything else is for the uniqueId we had, or about to have
+        } else if (type == PacketType::REJOIN) {
+            connected = false;
+            ++rejoins;
+            swarm.botsById.erase(uniqueId);
+            SendConnectRequest(receivedAt);
+        } else if (type == PacketType::HOST_PLAYERS or type == PacketType::HOST_SPRITES) {
+            if (!ReadHostGameStatePart(packet, type, part)) continue;
+            link.Received(part.number, receivedAt);
+            if (type == PacketType::HOST_PLAYERS) HandleHostPlayers(swarm, receivedAt);
+        } else if (type == PacketType::PARTY_REQUEST) {
+            if (!ReadPartyRequest(packet, partyHashes)) continue;
+            auto count = WritePartiesMessages(partyMessages, partyHashes, parties, 1); // Only ever asked for our own
+            for (std::size_t message = 0; message < count; ++message) {
+                Send(partyMessages[message]);
+            }
+        } else if (type == PacketType::PARTIES) {
+            if (!ReadParties(packet, receivedParties)) continue;
+            for (auto const& party : receivedParties) {
+                knownParties.insert(PartyCache::Hash(party.data()));
+            }
+        }
+        // Battle requests are never accepted, so no other generic request comes
+    }
+}
+
+/**
+ * Takes the round trip from our own entry, and how stale every other bot's was, and asks for parties we don't have.
+ */
+void Bot::HandleHostPlayers(Swarm& swarm, std::chrono::steady_clock::time_point receivedAt) {
+    std::chrono::steady_clock::time_point sentAt;
+    for (auto const& player : part.players) {
+        if (player.uniqueId == uniqueId) {
+            if (sendTimes.Find(player.echo.sequence, sentAt)) link.RoundTrip(sentAt, player.echo, receivedAt);
+            continue;
+        }
+
+        // The host's echo of the player is the latest game state it had from them, which is what this entry holds
+        auto other = swarm.botsById.find(player.uniqueId);
+        if (other != swarm.botsById.end() and other->second->sendTimes.Find(player.echo.sequence, sentAt)) {
+            swarm.staleness.Add(Milliseconds(receivedAt - sentAt));
+        }
+        if (!knownParties.count(player.partyHash) and
+            std::find(wantedParties.begin(), wantedParties.end(), player.partyHash) == wantedParties.end()) {
+            wantedParties.push_back(player.partyHash);
+        }
+    }
+
+    if (!wantedParties.empty()) {
+        sf::Packet requestPacket;
+        WritePartyRequest(requestPacket, wantedParties);
+        Send(requestPacket);
+        wantedParties.clear();
+    }
+}
+
+Swarm::Swarm(std::size_t size, sf::IpAddress host, unsigned short hostPort) {
+    for (std::size_t index = 0; index < size; ++index) {
+        bots.emplace_back(new Bot(index, size, host, hostPort));
+    }
+}
+
+/**
+ * Binds every bot and starts them connecting. Returns false if any can't be bound.
+ */
+bool Swarm::Start() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& bot : bots) {
+        if (!bot->Start(now)) {
+            std::cout << "Failed to bind a bot's socket." << std::endl;
+            return false;
+        }
+        auto botPointer = bot.get();
+        eventLoop.Watch(bot->transport, [this, botPointer]() {botPointer->Receive(*this, received);});
+    }
+    eventLoop.Every(kPollInterval, [this]() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto& bot : bots) {
+            bot->Update(*this, now);
+        }
+    });
+    return eventLoop.Start();
+}
+
+void Swarm::Stop() {
+    eventLoop.Stop();
+}
+
+void Swarm::Collect(SwarmResult& result) const {
+    result.clients = bots.size();
+    std::size_t roundTrips = 0;
+    for (auto const& bot : bots) {
+        if (bot->connectedAt != std::chrono::steady_clock::time_point()) {
+            ++result.connected;
+            result.slowestConnect = std::max(result.slowestConnect, Milliseconds(bot->connectedAt - bot->startedAt));
+        }
+        result.rejoins += bot->rejoins;
+        result.partyChanges += bot->partyChanges;
+        result.battleRequests += bot->battleRequests;
+        result.packetsExpected += bot->link.PacketsExpected();
+        result.packetsLost += bot->link.PacketsLost();
+        if (bot->link.roundTrips > 0) {
+            result.roundTrip += bot->link.roundTrip;
+            ++roundTrips;
+        }
+    }
+    result.roundTrip = roundTrips > 0 ? result.roundTrip / roundTrips : 0;
+    result.staleness = staleness;
+}
+
+/**
+ * Adds up the loss on the host's links to the bots.
+ */
+void CollectHostLinks(std::unordered_map<int, LinkStats> const& links, SwarmResult& result) {
+    for (auto const& link : links) {
+        result.hostPacketsExpected += link.second.PacketsExpected();
+        result.hostPacketsLost += link.second.PacketsLost();
+    }
+}
+
+/**
+ * Runs a game's host headless with the swarm for the duration, timing the network's part of its frames.
+ */
+bool RunGameHost(std::string const& game, std::string const& save, unsigned short port, std::size_t clients,
+                 std::chrono::seconds duration, SwarmResult& result) {
+    GameBoy gameboy;
+    gameboy.StartNetwork("host", 0, "", port);
+    if (gameboy.network.networkMode != NetworkMode::CONNECTED_AS_HOST) return false;
+    gameboy.LoadGame(game, save);
+
+    Swarm swarm(clients, sf::IpAddress::LocalHost, port);
+    if (!swarm.Start()) return false;
+
+    // A tick is every frame from one game state exchange up to the next
+    uint64_t ticks = 0;
+    uint64_t tickTime = 0;
+    uint64_t totalTime = 0;
+    uint64_t worstTime = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start;
+    while (deadline - start < duration) {
+        gameboy.RenderFrame();
+        tickTime += gameboy.frameCounters.networkTime;
+        if (gameboy.updateCounter % gameboy.updateRate == 0) {
+            ++ticks;
+            totalTime += tickTime;
+            worstTime = std::max(worstTime, tickTime);
+            tickTime = 0;
+        }
+        deadline += kFrameDuration;
+        std::this_thread::sleep_until(deadline);
+    }
+    swarm.Stop();
+
+    swarm.Collect(result);
+    CollectHostLinks(gameboy.network.Links(), result);
+    result.hostMeasured = true;
+    result.averageTick = ticks > 0 ? totalTime / 1e6 / ticks : 0;
+    result.worstTick = worstTime / 1e6;
+    return true;
+}
+
+/**
+ * Runs a Relay with the swarm for the duration, ticking it as RelayServer does.
+ */
+bool RunRelay(unsigned short port, std::chrono::nanoseconds tick, std::size_t clients, std::chrono::seconds duration,
+              SwarmResult& result) {
+    Relay relay;
+    if (!relay.Start(port)) return false;
+
+    Swarm swarm(clients, sf::IpAddress::LocalHost, port);
+    if (!swarm.Start()) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start;
+    while (deadline - start < duration) {
+        relay.Tick();
+        deadline += tick;
+        std::this_thread::sleep_until(deadline);
+    }
+    swarm.Stop();
+
+    swarm.Collect(result);
+    CollectHostLinks(relay.Links(), result);
+    auto const& stats = relay.Stats();
+    result.hostMeasured = true;
+    result.averageTick = stats.ticks > 0 ? stats.cpuTime.count() / 1e6 / stats.ticks : 0;
+    result.worstTick = stats.maxTickCpuTime.count() / 1e6;
+    return true;
+}
+
+/**
+ * Loads a host in another process with the swarm for the duration.
+ */
+bool RunRemoteHost(sf::IpAddress host, unsigned short port, std::size_t clients, std::chrono::seconds duration,
+                   SwarmResult& result) {
+    Swarm swarm(clients, host, port);
+    if (!swarm.Start()) return false;
+    std::this_thread::sleep_for(duration);
+    swarm.Stop();
+    swarm.Collect(result);
+    return true;
+}
+
+void PrintResult(SwarmResult const& result) {
+    auto const& staleness = result.staleness;
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(4) << result.clients << " clients (" << result.connected << " connected, slowest in "
+              << result.slowestConnect << "ms, " << result.rejoins << " rejoins)" << std::endl;
+    std::cout << "    Tick: ";
+    if (result.hostMeasured) {
+        std::cout << result.averageTick << "ms average, " << result.worstTick << "ms worst";
+    } else {
+        std::cout << "unknown";
+    }
+    std::cout << "\tLost to host: ";
+    if (result.hostMeasured) {
+        std::cout << result.hostPacketsLost * 100.0 / std::max<uint64_t>(result.hostPacketsExpected, 1) << "%";
+    } else {
+        std::cout << "unknown";
+    }
+    std::cout << "\tLost from host: " << result.packetsLost * 100.0 / std::max<uint64_t>(result.packetsExpected, 1) << "%"
+              << "\tRTT: " << result.roundTrip << "ms" << std::endl;
+    std::cout << "    Staleness: " << staleness.Average() << "ms average, " << staleness.Percentile(0.5) << "ms median, "
+              << staleness.Percentile(0.99) << "ms 99th percentile, " << staleness.Max() << "ms worst ("
+              << staleness.Count() << " samples)"
+              << "\tParty changes: " << result.partyChanges << "\tBattle requests: " << result.battleRequests << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string game_name = "";
+    std::string save_file = "";
+    std::string host = "";
+    bool relay = false;
+    unsigned short port = 34232;
+    std::chrono::nanoseconds tick = 12*kFrameDuration;
+    std::vector<std::size_t> swarmSizes = {8, 64, 256};
+    int duration = 10;
+    bool verbose = false;
+    for (int argument = 1; argument < argc; ++argument) {
+        auto arg = std::string(argv[argument]);
+        if (arg.find("-game=") == 0) {
+            game_name = arg.substr(6);
+        } else if (arg.find("-save=") == 0) {
+            save_file = arg.substr(6);
+        } else if (arg.find("-host=") == 0) {
+            host = arg.substr(6);
+        } else if (arg == "-relay") {
+            relay = true;
+        } else if (arg.find("-port=") == 0) {
+            port = std::stoi(arg.substr(6));
+        } else if (arg.find("-tick=") == 0) {
+            tick = std::chrono::milliseconds(std::stoi(arg.substr(6)));
+        } else if (arg.find("-clients=") == 0) {
+            swarmSizes.clear();
+            std::istringstream sizes(arg.substr(9));
+            std::string size;
+            while (std::getline(sizes, size, ',')) {
+                swarmSizes.push_back(std::stoi(size));
+            }
+        } else if (arg.find("-duration=") == 0) {
+            duration = std::stoi(arg.substr(10));
+        } else if (arg == "-verbose") {
+            verbose = true;
+        }
+    }
+    if (game_name == "" and !relay and host == "") {
+        std::cout << "Give a game to host with -game=, -relay, or a host to load with -host=." << std::endl;
+        return 1;
+    }
+
+    NullBuffer discard;
+    for (auto clients : swarmSizes) {
+        SwarmResult result;
+        auto console = std::cout.rdbuf();
+        if (!verbose) std::cout.rdbuf(&discard);
+        bool ran;
+        if (host != "") {
+            ran = RunRemoteHost(sf::IpAddress(host), port, clients, std::chrono::seconds(duration), result);
+        } else if (relay) {
+            ran = RunRelay(port, tick, clients, std::chrono::seconds(duration), result);
+        } else {
+            ran = RunGameHost(game_name, save_file, port, clients, std::chrono::seconds(duration), result);
+        }
+        std::cout.rdbuf(console);
+
+        if (!ran) {
+            std::cout << "Failed to run " << clients << " clients (is the port free, or the host running?)" << std::endl;
+            return 1;
+        }
+        PrintResult(result);
+    }
+    return 0;
+}
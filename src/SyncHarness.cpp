@@ -0,0 +1,332 @@
+//
+// Created by Austin on 10/19/2026.
+//
+// Runs a host and several clients in one process, headless and connected over a LoopbackNetwork, drives them with
+// scripted input, and reports how well they keep in sync: how long clients' NPCs take to converge on the host's, the
+// bytes each exchanged, every link's stats, and how long battle turns take to cross. Run from bin/Release like the
+// emulator:
+//
+//   SyncHarness -game=ROM [-save=FILE] [-clients=N] [-duration=SECONDS] [-script=FILE]
+//               [-latency=MS] [-jitter=MS] [-loss=PERCENT] [-reorder=PERCENT] [-seed=N]
+//
+// Instance 0 is the host and 1 to N its clients. A script has a line for each input, by frame (60 a second):
+//
+//   <frame> <instance> down|up LEFT|RIGHT|UP|DOWN|A|B|START|SELECT
+//   <frame> <client> turn
+//
+// Without one, the host walks left and right, and the clients take turns battling it every 5 seconds. NPCs only mean
+// anything with a Pokemon ROM and a save far enough in to walk around.
+//
+// A battle turn here is the network's part of one: the client and the host both send the move they chose, as the game
+// does once a move is picked, and the turn is over once each has the other's. Only one is under way at a time, as the
+// host battles one player at once; any scripted while one is waits its turn.
+//
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameBoy.hpp"
+#include "InstanceHost.hpp"
+#include "LoopbackTransport.hpp"
+
+namespace {
+    unsigned short const kHostPort = 34232;
+    unsigned short const kFirstClientPort = 34300;
+}
+
+/**
+ * One line of a script.
+ */
+struct ScriptedInput {
+    uint64_t frame;
+    std::size_t instance;
+    bool turn; // A battle turn between the client and the host, rather than a key
+    bool down;
+    KeyType key;
+};
+
+/**
+ * One of the instances, with what's been measured of it.
+ */
+struct Peer {
+    std::unique_ptr<GameBoy> gameboy;
+    std::unique_ptr<LoopbackTransport> transport;
+    std::string name;
+
+    bool outOfSync = false; // Whether the last sync found NPCs out of place, since outOfSyncAt
+    std::chrono::steady_clock::time_point outOfSyncAt;
+    std::vector<double> convergenceTimes; // Milliseconds from NPCs being found out of place to all being in place
+};
+
+/**
+ * Summarizes times in milliseconds.
+ */
+void WriteTimes(std::ostream& output, std::vector<double> const& times) {
+    if (times.empty()) {
+        output << "none";
+        return;
+    }
+    double total = 0;
+    for (auto time : times) total += time;
+    output << times.size() << ", " << total / times.size() << "ms average, "
+           << *std::max_element(times.begin(), times.end()) << "ms worst";
+}
+
+bool ParseKey(std::string const& name, KeyType& key) {
+    std::vector<std::pair<std::string, KeyType>> const keys = {
+        {"LEFT", KeyType::LEFT}, {"RIGHT", KeyType::RIGHT}, {"UP", KeyType::UP}, {"DOWN", KeyType::DOWN},
+        {"A", KeyType::A}, {"B", KeyType::B}, {"START", KeyType::START}, {"SELECT", KeyType::SELECT}};
+    for (auto const& entry : keys) {
+        if (entry.first == name) {
+            key = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Reads a script, returning false (having said why) if any line can't be.
+ */
+bool ReadScript(std::string const& file_name, std::size_t instances, std::vector<ScriptedInput>& script) {
+    std::ifstream file(file_name);
+    if (!file) {
+        std::cout << "Failed to open script: " << file_name << std::endl;
+        return false;
+    }
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        if (line.empty() or line[0] == '#') continue;
+        std::istringstream fields(line);
+        ScriptedInput input{0, 0, false, false, KeyType::NONE};
+        std::string action, key;
+        fields >> input.frame >> input.instance >> action;
+        if (action != "turn") fields >> key;
+        input.turn = action == "turn";
+        input.down = action == "down";
+        bool valid = !fields.fail() and input.instance < instances;
+        if (input.turn) {
+            valid = input.instance > 0 and input.instance < instances;
+        } else {
+            valid = valid and (input.down or action == "up") and ParseKey(key, input.key);
+        }
+        if (!valid) {
+            std::cout << "Bad script line " << number << ": " << line << std::endl;
+            return false;
+        }
+        script.push_back(input);
+    }
+    std::stable_sort(script.begin(), script.end(),
+                     [](ScriptedInput const& left, ScriptedInput const& right) {return left.frame < right.frame;});
+    return true;
+}
+
+/**
+ * The script run without one: the host walks a few steps left and back every 2 seconds, and a client takes a battle
+ * turn with it every 5.
+ */
+std::vector<ScriptedInput> DefaultScript(std::size_t clients, uint64_t frames) {
+    std::vector<ScriptedInput> script;
+    for (uint64_t frame = 60; frame < frames; frame += 120) {
+        auto key = (frame / 120) % 2 == 0 ? KeyType::LEFT : KeyType::RIGHT;
+        script.push_back({frame, 0, false, true, key});
+        script.push_back({frame + 48, 0, false, false, key});
+    }
+    for (uint64_t frame = 300, turn = 0; frame < frames and clients > 0; frame += 300, ++turn) {
+        script.push_back({frame, 1 + turn % clients, true, false, KeyType::NONE});
+    }
+    std::stable_sort(script.begin(), script.end(),
+                     [](ScriptedInput const& left, ScriptedInput const& right) {return left.frame < right.frame;});
+    return script;
+}
+
+/**
+ * Notes whether the client's NPCs were all where the host had them at its last sync, timing how long it took for them
+ * to get there once they weren't.
+ */
+void MeasureConvergence(Peer& peer, std::chrono::steady_clock::time_point now) {
+    auto outOfSync = peer.gameboy->spritesOutOfSync;
+    if (outOfSync > 0 and !peer.outOfSync) {
+        peer.outOfSync = true;
+        peer.outOfSyncAt = now;
+    } else if (outOfSync == 0 and peer.outOfSync) {
+        peer.outOfSync = false;
+        peer.convergenceTimes.push_back(std::chrono::duration<double, std::milli>(now - peer.outOfSyncAt).count());
+    }
+}
+
+/**
+ * Battle turns between the host and one client at a time.
+ */
+class BattleTurns {
+public:
+    std::deque<std::size_t> waiting; // Clients with a turn scripted, in order
+    std::vector<double> times; // Milliseconds each finished turn took
+
+    /**
+     * Starts the next waiting turn if none is under way, or finishes the one that is if both have the other's move.
+     */
+    void Update(std::vector<Peer>& peers, std::chrono::steady_clock::time_point now) {
+        auto& host = peers[0].gameboy->network;
+        if (client != 0) {
+            auto& network = peers[client].gameboy->network;
+            if (host.moveSent or network.moveSent) return;
+
+            times.push_back(std::chrono::duration<double, std::milli>(now - startedAt).count());
+            host.inBattle = network.inBattle = false;
+            host.pendingRequests.clear(); // As the battle ending would, so the moves aren't sent again
+            network.pendingRequests.clear();
+            client = 0;
+        }
+
+        while (!waiting.empty()) {
+            auto next = waiting.front();
+            waiting.pop_front();
+            auto& network = peers[next].gameboy->network;
+            if (network.networkMode != NetworkMode::CONNECTED_AS_CLIENT) continue; // Skipped, not joined yet
+
+            // Both start from the same turn, however many either had with anyone else
+            host.battleTurn = network.battleTurn = std::max(host.battleTurn, network.battleTurn);
+            host.inBattle = network.inBattle = true;
+            host.SendPlayerMove(network.uniqueId, 1, 0, 0);
+            network.SendPlayerMove(host.uniqueId, 1, 0, 0);
+            client = next;
+            startedAt = now;
+            break;
+        }
+    }
+
+    bool UnderWay() const {return client != 0;}
+
+private:
+    std::size_t client = 0; // Whose turn is under way, 0 for none
+    std::chrono::steady_clock::time_point startedAt;
+};
+
+int main(int argc, char* argv[]) {
+    std::string game_name = "";
+    std::string save_file = "";
+    std::string script_file = "";
+    std::size_t clients = 3;
+    int duration = 30;
+    LinkConditions conditions;
+    uint32_t seed = 1;
+    for (int argument = 1; argument < argc; ++argument) {
+        auto arg = std::string(argv[argument]);
+        if (arg.find("-game=") == 0) {
+            game_name = arg.substr(6);
+        } else if (arg.find("-save=") == 0) {
+            save_file = arg.substr(6);
+        } else if (arg.find("-clients=") == 0) {
+            clients = std::stoi(arg.substr(9));
+        } else if (arg.find("-duration=") == 0) {
+            duration = std::stoi(arg.substr(10));
+        } else if (arg.find("-script=") == 0) {
+            script_file = arg.substr(8);
+        } else if (arg.find("-latency=") == 0) {
+            conditions.latency = std::chrono::milliseconds(std::stoi(arg.substr(9)));
+        } else if (arg.find("-jitter=") == 0) {
+            conditions.jitter = std::chrono::milliseconds(std::stoi(arg.substr(8)));
+        } else if (arg.find("-loss=") == 0) {
+            conditions.loss = std::stod(arg.substr(6)) / 100;
+        } else if (arg.find("-reorder=") == 0) {
+            conditions.reorder = std::stod(arg.substr(9)) / 100;
+        } else if (arg.find("-seed=") == 0) {
+            seed = std::stoul(arg.substr(6));
+        }
+    }
+    if (game_name == "") {
+        std::cout << "No game loaded." << std::endl;
+        return 1;
+    }
+
+    auto frames = static_cast<uint64_t>(duration) * 60;
+    std::vector<ScriptedInput> script;
+    if (script_file == "") {
+        script = DefaultScript(clients, frames);
+    } else if (!ReadScript(script_file, clients + 1, script)) {
+        return 1;
+    }
+
+    LoopbackNetwork network(seed);
+    network.SetConditions(conditions);
+    std::vector<Peer> peers(clients + 1);
+    for (std::size_t index = 0; index < peers.size(); ++index) {
+        auto& peer = peers[index];
+        peer.gameboy.reset(new GameBoy());
+        peer.transport.reset(new LoopbackTransport(network));
+        peer.gameboy->network.UseTransport(peer.transport.get());
+        if (index == 0) {
+            peer.name = "host";
+            peer.gameboy->StartNetwork(peer.name, 0, "", kHostPort);
+        } else {
+            peer.name = "client" + std::to_string(index);
+            peer.gameboy->StartNetwork(peer.name, kFirstClientPort + index, "127.0.0.1", kHostPort);
+        }
+        peer.gameboy->LoadGame(game_name, save_file);
+    }
+
+    // Every instance runs a frame in turn, paced to real time so the loopback's latency means what it says
+    BattleTurns turns;
+    std::size_t nextInput = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start;
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        for (; nextInput < script.size() and script[nextInput].frame <= frame; ++nextInput) {
+            auto const& input = script[nextInput];
+            if (input.turn) {
+                turns.waiting.push_back(input.instance);
+            } else if (input.down) {
+                peers[input.instance].gameboy->input.KeyDown(input.key);
+            } else {
+                peers[input.instance].gameboy->input.KeyUp(input.key);
+            }
+        }
+
+        for (auto& peer : peers) {
+            peer.gameboy->RenderFrame();
+        }
+        auto now = std::chrono::steady_clock::now();
+        for (std::size_t index = 1; index < peers.size(); ++index) {
+            MeasureConvergence(peers[index], now);
+        }
+        turns.Update(peers, now);
+
+        deadline += kFrameDuration;
+        std::this_thread::sleep_until(deadline);
+    }
+
+    auto loopback = network.Stats();
+    std::cout << std::fixed << std::setprecision(1)
+              << "Instances: 1 host, " << clients << " clients\tFrames: " << frames
+              << "\tConditions: " << conditions.latency.count() / 1000.0 << "ms latency, "
+              << conditions.jitter.count() / 1000.0 << "ms jitter, " << conditions.loss * 100 << "% lost, "
+              << conditions.reorder * 100 << "% reordered" << std::endl
+              << "Loopback: " << loopback.sent << " datagrams, " << loopback.bytes << " bytes\tLost: " << loopback.lost
+              << "\tReordered: " << loopback.reordered << "\tUnreachable: " << loopback.unreachable << std::endl;
+    for (std::size_t index = 0; index < peers.size(); ++index) {
+        auto& peer = peers[index];
+        auto const& counters = peer.gameboy->totalCounters;
+        std::cout << std::fixed << std::setprecision(1) << peer.name << ": " << counters.networkBytesIn << " bytes in, "
+                  << counters.networkBytesOut << " bytes out";
+        if (index > 0) {
+            std::cout << "\tNPC convergence: ";
+            WriteTimes(std::cout, peer.convergenceTimes);
+            if (peer.outOfSync) std::cout << " (still out of sync)";
+        }
+        std::cout << std::endl;
+        peer.gameboy->network.ReportLinks(std::cout);
+    }
+    std::cout << std::fixed << std::setprecision(1) << "Battle turns: ";
+    WriteTimes(std::cout, turns.times);
+    std::cout << "\tUnfinished: " << turns.waiting.size() + (turns.UnderWay() ? 1 : 0) << std::endl;
+    return 0;
+}
@@ -0,0 +1,268 @@
+//
+// Created by Austin on 10/19/2026.
+//
+// Runs the test ROMs in rom/ headless, several at once, and writes a JSON report of which passed along with how long
+// each took in emulated cycles and host time. Run from bin/Release like the emulator:
+//
+//   TestRomRunner [-threads=N] [-frames=N] [-report=file.json] [-no-predecode] [-no-idle-skip]
+//                 [-expect=ROM=SCREENHASH ...] [ROM ...]
+//
+// With no ROMs given, runs every bundled test ROM. Blargg's ROMs report their result over the serial port ("Passed" or
+// "Failed"); any other ROM needs an -expect screen hash, and passes once its frame matches it.
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "GameBoy.hpp"
+
+std::vector<std::string> const kTestRoms = {"cpu_instrs.gb",
+                                            "01-special.gb",
+                                            "02-interrupts.gb",
+                                            "03-op sp,hl.gb",
+                                            "04-op r,imm.gb",
+                                            "05-op rp.gb",
+                                            "06-ld r,r.gb",
+                                            "07-jr,jp,call,ret,rst.gb",
+                                            "08-misc instrs.gb",
+                                            "09-op r,r.gb",
+                                            "10-bit ops.gb",
+                                            "11-op a,(hl).gb",
+                                            "01-read_timing.gb",
+                                            "02-write_timing.gb",
+                                            "03-modify_timing.gb"};
+
+enum class TestResult {
+    PASSED,
+    FAILED,
+    TIMED_OUT
+};
+
+/**
+ * A test ROM to run and, once run, how it went.
+ */
+struct TestRom {
+    std::string name;
+    bool hasExpectedScreenHash = false;
+    uint64_t expectedScreenHash = 0;
+
+    TestResult result = TestResult::TIMED_OUT;
+    std::string detectedBy; // "serial" or "screen"
+    uint64_t frames = 0;
+    uint64_t cycles = 0; // Clock cycles (4.194304MHz) until the result was known
+    double wallSeconds = 0.0;
+    uint64_t screenHash = 0;
+    std::string serialOutput;
+    std::size_t idleLoops = 0;
+    uint64_t idleCycles = 0; // Clock cycles of idle loops skipped rather than run
+};
+
+/**
+ * Runs the ROM until it reports a result or maxFrames frames pass.
+ */
+void RunTestRom(TestRom& test, uint64_t maxFrames, bool predecode, bool skipIdleLoops) {
+    auto start = std::chrono::steady_clock::now();
+
+    GameBoy gameboy;
+    gameboy.cpu.predecode = predecode;
+    gameboy.idleLoops.enabled = skipIdleLoops;
+    gameboy.mmu.recordSerial = true;
+    gameboy.LoadGame(test.name, "");
+
+    auto const& serial = gameboy.mmu.serialOutput;
+    while (test.frames < maxFrames) {
+        // Only the emulation and the finished frame are needed, not networking, input or .sav writes
+        gameboy.RunCycles(GameBoy::kCyclesPerFrame);
+        gameboy.display.RenderFrame();
+        ++test.frames;
+
+        // Wait for the line with the result to finish, as it may say which test failed
+        if (!serial.empty() and serial.back() == '\n') {
+            if (serial.find("Passed") != std::string::npos) {
+                test.result = TestResult::PASSED;
+                test.detectedBy = "serial";
+                break;
+            } else if (serial.find("Failed") != std::string::npos) {
+                test.result = TestResult::FAILED;
+                test.detectedBy = "serial";
+                break;
+            }
+        }
+
+        if (test.hasExpectedScreenHash and gameboy.display.FrameHash() == test.expectedScreenHash) {
+            test.result = TestResult::PASSED;
+            test.detectedBy = "screen";
+            break;
+        }
+    }
+
+    // Screen hash tests that never matched have failed rather than timed out
+    if (test.result == TestResult::TIMED_OUT and test.hasExpectedScreenHash) {
+        test.result = TestResult::FAILED;
+        test.detectedBy = "screen";
+    }
+
+    test.cycles = gameboy.cpu.clock * 4;
+    test.screenHash = gameboy.display.FrameHash();
+    test.serialOutput = serial;
+    test.idleLoops = gameboy.idleLoops.LoopsFound();
+    test.idleCycles = gameboy.idleLoops.CyclesSkipped() * 4;
+    test.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string ResultName(TestResult result) {
+    switch (result) {
+        case TestResult::PASSED:    return "passed";
+        case TestResult::FAILED:    return "failed";
+        case TestResult::TIMED_OUT: return "timed_out";
+    }
+    return "";
+}
+
+std::string JsonString(std::string const& text) {
+    std::ostringstream json;
+    json << '"';
+    for (char character : text) {
+        switch (character) {
+            case '"':  json << "\\\""; break;
+            case '\\': json << "\\\\"; break;
+            case '\n': json << "\\n"; break;
+            case '\r': json << "\\r"; break;
+            case '\t': json << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(character) < 0x20 or static_cast<unsigned char>(character) > 0x7E) {
+                    json << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                         << static_cast<unsigned int>(static_cast<unsigned char>(character)) << std::dec;
+                } else {
+                    json << character;
+                }
+        }
+    }
+    json << '"';
+    return json.str();
+}
+
+std::string HexString(uint64_t value) {
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << value;
+    return hex.str();
+}
+
+void WriteReport(std::ostream& output, std::vector<TestRom> const& tests, std::size_t threads, double wallSeconds) {
+    std::unordered_map<int, int> totals;
+    for (auto const& test : tests) {
+        ++totals[static_cast<int>(test.result)];
+    }
+
+    output << std::fixed << std::setprecision(3)
+           << "{\n"
+           << "  \"threads\": " << threads << ",\n"
+           << "  \"wall_seconds\": " << wallSeconds << ",\n"
+           << "  \"passed\": " << totals[static_cast<int>(TestResult::PASSED)] << ",\n"
+           << "  \"failed\": " << totals[static_cast<int>(TestResult::FAILED)] << ",\n"
+           << "  \"timed_out\": " << totals[static_cast<int>(TestResult::TIMED_OUT)] << ",\n"
+           << "  \"roms\": [\n";
+    for (std::size_t index = 0; index < tests.size(); ++index) {
+        auto const& test = tests[index];
+        double emulatedSeconds = test.cycles / 4194304.0;
+        output << "    {\"rom\": " << JsonString(test.name)
+               << ", \"result\": \"" << ResultName(test.result) << "\""
+               << ", \"detected_by\": " << (test.detectedBy.empty() ? "null" : JsonString(test.detectedBy))
+               << ", \"frames\": " << test.frames
+               << ", \"cycles\": " << test.cycles
+               << ", \"wall_seconds\": " << test.wallSeconds
+               << ", \"speed\": " << (test.wallSeconds > 0.0 ? emulatedSeconds / test.wallSeconds : 0.0)
+               << ", \"idle_loops\": " << test.idleLoops
+               << ", \"idle_cycles_skipped\": " << test.idleCycles
+               << ", \"screen_hash\": \"" << HexString(test.screenHash) << "\""
+               << ", \"serial_output\": " << JsonString(test.serialOutput) << "}"
+               << (index + 1 < tests.size() ? ",\n" : "\n");
+    }
+    output << "  ]\n}" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    uint64_t maxFrames = 60*120; // Two minutes of emulated time, cpu_instrs needs just under one
+    std::string reportFile = "test_rom_report.json";
+    bool predecode = true;
+    bool skipIdleLoops = true;
+    std::unordered_map<std::string, uint64_t> expectedScreenHashes;
+    std::vector<TestRom> tests;
+    for (int argument = 1; argument < argc; ++argument) {
+        auto arg = std::string(argv[argument]);
+        if (arg.find("-threads=") == 0) {
+            threads = std::max(std::stoi(arg.substr(9)), 1);
+        } else if (arg.find("-frames=") == 0) {
+            maxFrames = std::stoull(arg.substr(8));
+        } else if (arg.find("-report=") == 0) {
+            reportFile = arg.substr(8);
+        } else if (arg.find("-no-predecode") == 0) {
+            predecode = false;
+        } else if (arg.find("-no-idle-skip") == 0) {
+            skipIdleLoops = false;
+        } else if (arg.find("-expect=") == 0) {
+            // ROM names can contain most anything, but not '='
+            auto separator = arg.rfind('=');
+            expectedScreenHashes[arg.substr(8, separator - 8)] = std::stoull(arg.substr(separator + 1), nullptr, 16);
+        } else {
+            TestRom test;
+            test.name = arg;
+            tests.push_back(test);
+        }
+    }
+
+    if (tests.empty()) {
+        for (auto const& name : kTestRoms) {
+            TestRom test;
+            test.name = name;
+            tests.push_back(test);
+        }
+    }
+    for (auto& test : tests) {
+        auto expected = expectedScreenHashes.find(test.name);
+        if (expected != expectedScreenHashes.end()) {
+            test.hasExpectedScreenHash = true;
+            test.expectedScreenHash = expected->second;
+        }
+    }
+
+    // Each worker takes the next ROM nobody has started yet
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<std::size_t> nextTest(0);
+    std::vector<std::thread> workers;
+    for (std::size_t thread = 0; thread < std::min(threads, tests.size()); ++thread) {
+        workers.emplace_back([&]() {
+            for (std::size_t index = nextTest++; index < tests.size(); index = nextTest++) {
+                RunTestRom(tests[index], maxFrames, predecode, skipIdleLoops);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool allPassed = true;
+    for (auto const& test : tests) {
+        std::cout << std::left << std::setw(28) << test.name << std::setw(10) << ResultName(test.result)
+                  << std::right << std::setw(12) << test.cycles << " cycles "
+                  << std::fixed << std::setprecision(3) << std::setw(9) << test.wallSeconds << "s" << std::endl;
+        allPassed = allPassed and test.result == TestResult::PASSED;
+    }
+    std::cout << "Finished in " << wallSeconds << "s on " << threads << " threads, report written to " << reportFile
+              << std::endl;
+
+    std::ofstream report(reportFile);
+    WriteReport(report, tests, threads, wallSeconds);
+
+    return allPassed ? 0 : 1;
+}
@@ -5,18 +5,23 @@
 #include "Timer.hpp"
 #include "Processor.hpp"
 #include "MemoryManagementUnit.hpp"
+#include "PerformanceCounters.hpp"
 #include "Display.hpp"
+#include "Profiler.hpp"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 Timer::Timer() {
     Reset();
 }
 
-void Timer::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Display* display_) {
+void Timer::Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Display* display_, PerformanceCounters* counters_) {
     cpu = cpu_;
     mmu = mmu_;
     display = display_;
+    counters = counters_;
 }
 
 void Timer::Reset() {
@@ -32,6 +37,8 @@ void Timer::Reset() {
 }
 
 void Timer::Increment() {
+    PROFILE_SCOPE(ProfileZone::TIMER);
+    
     auto cycles = cpu->clock - clock; // Difference in clocks
 	
     divider_clock_tracker += cycles;
@@ -77,8 +84,10 @@ void Timer::Increment() {
             scanline_tracker -= 456/4;
             if (scanline < 144) {
                 display->RenderScanline(scanline);
+                ++counters->scanlines;
             } else if (scanline > 153) {
                 display->RenderScanline(0);
+                ++counters->scanlines;
             }
         }
         if (scanline > 153) {
@@ -125,4 +134,50 @@ void Timer::Increment() {
     clock = cpu->clock;
 
     //std::cout << "PC: " << std::hex << static_cast<unsigned int>(cpu->program_counter.word) << ", CYCLES: " << static_cast<unsigned int>(cycles) << ": \tDIV - " << static_cast<unsigned int>(divider_clock) << ", \tDIV Tracker - " << static_cast<unsigned int>(divider_clock_tracker) << ", \tCNT - " << static_cast<unsigned int>(counter_clock) << ", \tCNT Tracker - " << static_cast<unsigned int>(counter_clock_tracker) << std::endl;
-}
\ No newline at end of file
+}
+
+/**
+ * Returns how many more cycles can pass without the divider, counter, scanline or LCD status changing, so that many
+ * can be skipped at once (Skip) instead of an instruction at a time. 0 if the next instruction could change any of them.
+ */
+uint64_t Timer::CyclesUntilNextChange() const {
+    // Each Increment moves a tracker on by at most one period, so one that has fallen behind changes on every call
+    if (divider_clock_tracker >= 64) return 0;
+    uint64_t cycles = 63 - divider_clock_tracker;
+
+    uint8_t timer_control = mmu->zram[0xFF07&0xFF];
+    if (timer_control&0x04) {
+        std::array<uint64_t, 4> const counter_increment_counts = {{256, 4, 16, 64}};
+        auto counter_increment_count = counter_increment_counts[timer_control&0x03];
+        if (counter_clock_tracker >= counter_increment_count) return 0;
+        cycles = std::min(cycles, counter_increment_count - counter_clock_tracker);
+    }
+
+    if (mmu->zram[0xFF40&0xFF] & 0x80) {
+        if (scanline_tracker >= 456/4 - 1) return 0;
+        cycles = std::min(cycles, 456/4 - 1 - scanline_tracker);
+
+        // The LCD status mode also changes part way through each visible scanline
+        if (scanline < 144 and scanline_tracker <= 80/4) {
+            cycles = std::min(cycles, 80/4 - scanline_tracker);
+        } else if (scanline < 144 and scanline_tracker <= (80+172)/4) {
+            cycles = std::min(cycles, (80+172)/4 - scanline_tracker);
+        }
+    }
+    return cycles;
+}
+
+/**
+ * Moves the timers on by cycles that CyclesUntilNextChange said wouldn't change anything, leaving them exactly as
+ * calling Increment after every instruction in those cycles would have.
+ */
+void Timer::Skip(uint64_t cycles) {
+    divider_clock_tracker += cycles;
+    if (mmu->zram[0xFF07&0xFF]&0x04) {
+        counter_clock_tracker += cycles;
+    }
+    if (mmu->zram[0xFF40&0xFF] & 0x80) {
+        scanline_tracker += cycles;
+    }
+    clock += cycles;
+}
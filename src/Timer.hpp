@@ -10,6 +10,7 @@
 class Processor;
 class MemoryManagementUnit;
 class Display;
+struct PerformanceCounters;
 
 class Timer {
 public:
@@ -32,14 +33,17 @@ public:
 
     Timer();
 
-    void Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Display* display_);
+    void Initialize(Processor* cpu_, MemoryManagementUnit* mmu_, Display* display_, PerformanceCounters* counters_);
     void Reset();
     void Increment();
+    uint64_t CyclesUntilNextChange() const;
+    void Skip(uint64_t cycles);
 
 private:
     Processor* cpu;
     MemoryManagementUnit* mmu;
     Display* display;
+    PerformanceCounters* counters;
 };
 
 #endif //GAMEBOYEMULATOR_TIMER_HPP
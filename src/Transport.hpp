@@ -0,0 +1,54 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_TRANSPORT_HPP
+#define GAMEBOYEMULATOR_TRANSPORT_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <SFML/Network.hpp>
+
+/**
+ * Where to send a datagram.
+ */
+struct DatagramEndpoint {
+    sf::IpAddress address;
+    unsigned short port;
+};
+
+/**
+ * Packs an address and port into one key, for looking up who sent a datagram.
+ */
+inline uint64_t EndpointKey(sf::IpAddress const& address, unsigned short port) {
+    return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+}
+
+/**
+ * A datagram received as part of a batch.
+ */
+struct ReceivedDatagram {
+    sf::Packet packet;
+    sf::IpAddress sender;
+    unsigned short port;
+};
+
+/**
+ * What Network sends and receives its datagrams through: a UDP socket (DatagramTransport), or a network simulated in
+ * memory between peers in one process (LoopbackTransport). Delivery is unreliable either way, so nothing above it can
+ * tell the difference.
+ */
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    virtual bool Bind(unsigned short port) = 0; // 0 for any free port
+    virtual void SetBlocking(bool blocking) = 0;
+
+    virtual sf::Socket::Status Send(sf::Packet& packet, sf::IpAddress const& address, unsigned short port) = 0;
+    virtual std::size_t ReceiveBatch(std::vector<ReceivedDatagram>& datagrams) = 0; // Every datagram waiting
+    virtual std::size_t SendToAll(sf::Packet& packet, std::vector<DatagramEndpoint> const& destinations) = 0;
+};
+
+#endif //GAMEBOYEMULATOR_TRANSPORT_HPP
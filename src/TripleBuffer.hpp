@@ -0,0 +1,55 @@
+//
+// Created by Austin on 10/19/2026.
+//
+
+#ifndef GAMEBOYEMULATOR_TRIPLEBUFFER_HPP
+#define GAMEBOYEMULATOR_TRIPLEBUFFER_HPP
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+
+/**
+ * Hands the latest of a stream of values from one producer thread to one consumer thread without either ever waiting
+ * on the other. The producer fills Back() and publishes it; the consumer takes whatever was published last with
+ * Update() and reads Front(). Values published while the consumer is busy are replaced rather than queued.
+ *
+ * Each thread owns one of the three slots and the third is swapped between them, along with a bit saying whether it
+ * holds a value the consumer hasn't taken yet.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : back(0)
+        , middle(1)
+        , front(2) {
+    }
+
+    // Producer
+    T& Back() {return slots[back];}
+
+    void Publish() {
+        back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndex;
+    }
+
+    // Consumer, returning whether Front() changed
+    bool Update() {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    T& Front() {return slots[front];}
+
+private:
+    static uint8_t const kIndex = 0x03;
+    static uint8_t const kFresh = 0x04;
+
+    std::array<T, 3> slots;
+    uint8_t back;
+    std::atomic<uint8_t> middle;
+    uint8_t front;
+};
+
+#endif //GAMEBOYEMULATOR_TRIPLEBUFFER_HPP
@@ -1,30 +1,111 @@
 #include <iostream>
+#include <atomic>
 #include <chrono>
 #include <thread>
 
 using namespace std::literals;
 
 #include "GameBoy.hpp"
+#include "InstanceHost.hpp"
+#include "TripleBuffer.hpp"
 
-sf::RenderWindow window;
+/**
+ * A finished frame and the text to draw over it, handed from the emulation thread to the window's.
+ */
+struct PresentedFrame {
+    sf::Image image;
+    std::vector<TextToDisplay> text;
+};
 
-void DrawFrame(sf::Image const& frame, GameBoy& gameBoy) {
+void DrawFrame(sf::RenderWindow& window, PresentedFrame& frame) {
+    PROFILE_SCOPE(ProfileZone::PRESENT);
     window.clear(sf::Color::Green);
 	
     sf::Texture texture;
     texture.setSmooth(false);
-    texture.loadFromImage(frame, sf::IntRect(0, 0, 160, 144));
+    texture.loadFromImage(frame.image, sf::IntRect(0, 0, 160, 144));
     sf::Sprite sprite;
     sprite.setTexture(texture);
 	
     window.draw(sprite);
     
     // Draw any pending text
-    gameBoy.display.RenderText(window);
+    Display::RenderText(window, frame.text);
     
     window.display();
 }
 
+/**
+ * Runs the game on its own thread, paced by its own clock so a slow vsync or compositor on the window's thread can't
+ * take time from it, publishing every frame for the window's thread to present. Stops when running is cleared or the
+ * game's input says the window closed.
+ */
+void RunEmulation(GameBoy& gameboy, TripleBuffer<PresentedFrame>& frames, std::atomic<bool>& running) {
+    auto next_frame = std::chrono::steady_clock::now() + kFrameDuration;
+    while (running) {
+        auto result = gameboy.RenderFrame();
+        auto& frame = frames.Back();
+        frame.image = std::move(result.first);
+        frame.text = gameboy.display.TakeText();
+        frames.Publish();
+        if (!result.second) {
+            running = false;
+        }
+        
+        std::this_thread::sleep_until(next_frame);
+        next_frame += kFrameDuration;
+    }
+}
+
+/**
+ * Runs the game headless in many instances on a pool of threads instead of in a window, reporting every few seconds how
+ * well the instances are keeping up. Runs until the duration (in seconds) elapses, or forever if it is 0.
+ */
+void RunInstanceHost(InstanceHost& host, int duration) {
+    host.Start();
+    auto start_time = std::chrono::steady_clock::now();
+    while (duration == 0 or std::chrono::steady_clock::now() - start_time < std::chrono::seconds(duration)) {
+        std::this_thread::sleep_for(5s);
+        host.Report(std::cout);
+    }
+    host.Stop();
+    host.Report(std::cout);
+}
+
+/**
+ * Replays the movie headless as fast as possible, reporting the frame rate and whether every frame matched the
+ * recording. Returns false if the replay couldn't start or didn't match.
+ */
+bool RunReplay(std::string const& game_name, std::string const& save_file, std::string const& replay_file,
+               std::string const& counters_file, bool predecode, bool skip_idle_loops) {
+    GameBoy gameboy;
+    gameboy.cpu.predecode = predecode;
+    gameboy.idleLoops.enabled = skip_idle_loops;
+    gameboy.LoadGame(game_name, save_file);
+    if (counters_file != "" and !gameboy.WriteCountersCsv(counters_file)) {
+        std::cout << "Failed to open counters file: " << counters_file << std::endl;
+    }
+    if (!gameboy.movie.StartReplay(replay_file)) {
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    while (gameboy.movie.IsReplaying()) {
+        gameboy.RenderFrame();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    auto frames = gameboy.movie.CurrentFrame();
+    std::cout << "Replayed " << frames << " frames in " << seconds << "s (" << frames / seconds << " fps)" << std::endl;
+    gameboy.idleLoops.Report(std::cout, gameboy.cpu.clock);
+    if (gameboy.movie.FirstMismatchedFrame() >= 0) {
+        std::cout << "Frame " << gameboy.movie.FirstMismatchedFrame() << " does not match the recording" << std::endl;
+        return false;
+    }
+    std::cout << "All " << gameboy.movie.HashesChecked() << " checked frames match the recording" << std::endl;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     std::string game_name = "";
     std::string save_file = "";
@@ -32,12 +113,28 @@ int main(int argc, char* argv[]) {
     std::string name = "";
     unsigned short port = 34231;
     unsigned short hostPort = 34232;
+    std::size_t instances = 0;
+    std::size_t threads = std::thread::hardware_concurrency();
+    int duration = 0;
+    std::string record_file = "";
+    std::string replay_file = "";
+    bool snapshot = false;
+    std::string counters_file = "";
+    bool predecode = true;
+    bool skip_idle_loops = true;
+    int link_stats = 0;
+    int timeout = 5;
+    int connect_timeout = 30;
+#ifdef POKESYNCH_PROFILER
+    bool profile_overlay = false;
+    std::string profile_trace_file = "";
+#endif
     for (int argument = 1; argument < argc; ++argument) {
         auto arg = std::string(argv[argument]);
         if (arg.find("-game=") != std::string::npos) {
             // Game's File Name to load
             game_name = arg.substr(6);
-        } else if (arg.find("-host") != std::string::npos) {
+        } else if (arg == "-host") {
             // Just leave ip blank
         } else if (arg.find("-connect=") != std::string::npos) {
             ipAddress = arg.substr(9);
@@ -49,6 +146,46 @@ int main(int argc, char* argv[]) {
             hostPort = std::stoi(arg.substr(10));
         } else if (arg.find("-save=") == 0) {
             save_file = arg.substr(6);
+        } else if (arg.find("-instances=") == 0) {
+            // Run this many headless instances instead of a window
+            instances = std::stoi(arg.substr(11));
+        } else if (arg.find("-threads=") == 0) {
+            threads = std::stoi(arg.substr(9));
+        } else if (arg.find("-duration=") == 0) {
+            duration = std::stoi(arg.substr(10));
+        } else if (arg.find("-record=") == 0) {
+            // Record input to a movie file
+            record_file = arg.substr(8);
+        } else if (arg.find("-snapshot") == 0) {
+            // Start the recording from a snapshot instead of power on
+            snapshot = true;
+        } else if (arg.find("-replay=") == 0) {
+            // Replay a movie headless instead of playing
+            replay_file = arg.substr(8);
+        } else if (arg.find("-counters=") == 0) {
+            // Write each frame's performance counters to a CSV file
+            counters_file = arg.substr(10);
+        } else if (arg.find("-no-predecode") == 0) {
+            // Fetch every instruction a byte at a time, for comparing against the predecoded blocks
+            predecode = false;
+        } else if (arg.find("-no-idle-skip") == 0) {
+            // Run idle loops an instruction at a time instead of skipping them
+            skip_idle_loops = false;
+        } else if (arg.find("-link-stats=") == 0) {
+            // Print the round trip, jitter, loss and byte rates of every link this often
+            link_stats = std::stoi(arg.substr(12));
+        } else if (arg.find("-timeout=") == 0) {
+            // Drop clients (as host) or rejoin (as client) after hearing nothing for this long
+            timeout = std::stoi(arg.substr(9));
+        } else if (arg.find("-connect-timeout=") == 0) {
+            // Give up joining and play alone if the host hasn't answered in this long
+            connect_timeout = std::stoi(arg.substr(17));
+#ifdef POKESYNCH_PROFILER
+        } else if (arg.find("-profile-overlay") == 0) {
+            profile_overlay = true;
+        } else if (arg.find("-profile-trace=") == 0) {
+            profile_trace_file = arg.substr(15);
+#endif
         }
     }
 
@@ -57,19 +194,91 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    if (replay_file != "") {
+        return RunReplay(game_name, save_file, replay_file, counters_file, predecode, skip_idle_loops) ? 0 : 1;
+    }
+
+    if (instances > 0) {
+        InstanceHost host(instances, threads);
+        if (ipAddress != "") {
+            host.StartNetwork(name, port, ipAddress, hostPort);
+        }
+        for (std::size_t index = 0; index < host.NumberOfInstances(); ++index) {
+            auto& network = host.Instance(index).network;
+            network.linkReportInterval = std::chrono::seconds(link_stats);
+            network.clientTimeout = network.hostTimeout = std::chrono::seconds(timeout);
+            network.connectTimeout = std::chrono::seconds(connect_timeout);
+        }
+        host.LoadGame(game_name, save_file);
+        RunInstanceHost(host, duration);
+        return 0;
+    }
+
+    // Only created after choosing not to run headless, as any window (even unopened) needs a graphics context
+    sf::RenderWindow window;
     window.create(sf::VideoMode(160, 144), "GBS");
-    GameBoy gameboy(window, name, port, ipAddress, hostPort);
+    GameBoy gameboy(window);
+    gameboy.cpu.predecode = predecode;
+    gameboy.idleLoops.enabled = skip_idle_loops;
+    gameboy.StartNetwork(name, port, ipAddress, hostPort);
+    gameboy.network.linkReportInterval = std::chrono::seconds(link_stats);
+    gameboy.network.clientTimeout = gameboy.network.hostTimeout = std::chrono::seconds(timeout);
+    gameboy.network.connectTimeout = std::chrono::seconds(connect_timeout);
     gameboy.LoadGame(game_name, save_file);
+    if (record_file != "") {
+        gameboy.movie.StartRecording(record_file, snapshot);
+    }
+    if (counters_file != "" and !gameboy.WriteCountersCsv(counters_file)) {
+        std::cout << "Failed to open counters file: " << counters_file << std::endl;
+    }
+#ifdef POKESYNCH_PROFILER
+    gameboy.profiler.showOverlay = profile_overlay;
+    if (profile_trace_file != "") {
+        gameboy.profiler.StartTrace();
+    }
+#endif
 
-	bool running = true;
-    auto start_time = std::chrono::steady_clock::now();
-	auto next_frame = start_time + 16.75041876ms;
-    while(running) {
-		auto result = gameboy.RenderFrame();
-        DrawFrame(result.first, gameboy);
-        running = result.second;
+    // The window's events and drawing have to stay on the thread that created it, so the game runs on another
+    TripleBuffer<PresentedFrame> frames;
+    std::atomic<bool> running(true);
+    std::thread emulation(RunEmulation, std::ref(gameboy), std::ref(frames), std::ref(running));
+#ifdef POKESYNCH_PROFILER
+    Profiler present_profiler; // The emulation thread's profiler only sees its own thread
+#endif
+    while (running) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                running = false;
+            } else if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::P) {
+                // Print screen, with the text drawn over it (for some reason PrintScrn isn't supported by SFML)
+                window.capture().saveToFile(gameboy.mmu.game_title + ".png");
+            } else {
+                gameboy.input.QueueEvent(event);
+            }
+        }
         
-		std::this_thread::sleep_until(next_frame);
-		next_frame += 16.75041876ms;
+        if (frames.Update()) {
+#ifdef POKESYNCH_PROFILER
+            present_profiler.BeginFrame();
+#endif
+            DrawFrame(window, frames.Front());
+        } else {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    emulation.join();
+    window.close();
+    gameboy.movie.StopRecording();
+    gameboy.idleLoops.Report(std::cout, gameboy.cpu.clock);
+    gameboy.network.ReportDatagramSizes(std::cout);
+    
+#ifdef POKESYNCH_PROFILER
+    gameboy.profiler.Report(std::cout);
+    std::cout << "Presenting:" << std::endl;
+    present_profiler.Report(std::cout);
+    if (profile_trace_file != "" and !gameboy.profiler.WriteTrace(profile_trace_file)) {
+        std::cout << "Failed to write trace: " << profile_trace_file << std::endl;
     }
+#endif
 }
\ No newline at end of file